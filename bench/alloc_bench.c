@@ -0,0 +1,129 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// Counts the allocations made while tokenizing a corpus of command lines, once through the create_tokens/free_tokens
+// wrappers (a fresh block per line) and once through a single arena reused for every line.
+// Built with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=strdup (see the Makefile), so that every
+// allocation made by tokens.c goes through the counters below.
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ************** Including the necessary header file **************
+
+#include "../tokens.h"
+
+// ************** Define macros **************
+
+#define ROUNDS 100000 // how many times the corpus is tokenized
+
+// ************** Define global variables **************
+
+static const char *corpus[] = {
+    "ls -la /usr/local/bin\n",
+    "cat big.log | grep error | sort | uniq -c | sort -rn | head -n 20\n",
+    "make -j8 CFLAGS=\"-O2 -g\" all > build.log\n",
+    "echo \"hello world\" > out.txt; wc -l < out.txt\n",
+    "find . -name \"*.c\" -newer Makefile | xargs grep -n TODO\n",
+    "cd /tmp\n",
+    "git log --oneline --graph --decorate --all | less\n",
+    "( cd src; make clean ) & sleep 1\n",
+};
+
+static unsigned long allocations; // every call to malloc, calloc, realloc and strdup
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+char *__real_strdup(const char *string);
+
+// ************** Defining the wrapped allocators **************
+
+void *__wrap_malloc(size_t size)
+{
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+  allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  allocations++;
+  return __real_realloc(ptr, size);
+}
+
+char *__wrap_strdup(const char *string)
+{
+  allocations++;
+  return __real_strdup(string);
+}
+
+// ************** Defining the benchmark **************
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, unsigned long lines, unsigned long tokens, double elapsed)
+{
+  printf("%-14s %8.2f allocations/line  %10.0f lines/s  (%lu allocations for %lu lines, %lu tokens)\n",
+         name, (double)allocations / lines, lines / elapsed, allocations, lines, tokens);
+}
+
+int main(int argc, char **argv)
+{
+  size_t corpus_size = sizeof(corpus) / sizeof(corpus[0]);
+  unsigned long lines = ROUNDS * corpus_size;
+  unsigned long tokens = 0;
+
+  // through the compatibility wrappers
+  allocations = 0;
+  double start = now();
+  for (int round = 0; round < ROUNDS; ++round)
+  {
+    for (size_t line = 0; line < corpus_size; ++line)
+    {
+      char **line_tokens = create_tokens(corpus[line]);
+      for (char **token = line_tokens; *token != NULL; ++token)
+      {
+        tokens++;
+      }
+      free_tokens(line_tokens);
+    }
+  }
+  report("create_tokens", lines, tokens, now() - start);
+
+  // through a single tokenizer, whose arena is reset for every line
+  tokenizer_t ctx;
+  tokenizer_init(&ctx);
+
+  allocations = 0;
+  start = now();
+  for (int round = 0; round < ROUNDS; ++round)
+  {
+    for (size_t line = 0; line < corpus_size; ++line)
+    {
+      tokenize_into(&ctx, corpus[line], strlen(corpus[line]));
+    }
+  }
+  report("arena", lines, tokens, now() - start);
+  tokenizer_free(&ctx);
+
+  // a strdup per token and one array per line, as the tokenizer used to do
+  printf("%-14s %8.2f allocations/line  (one array plus one strdup per token)\n", "per-token", (double)(lines + tokens) / lines);
+
+  return 0;
+}
@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+
+# Measures sourcing a script of N `echo` lines, once with the echo builtin and once with /bin/echo (which still launches a
+# program for every line, the way every echo used to), and prints the time per line of each.
+#
+# usage: python3 bench/builtin_bench.py [N]
+
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+SHELL = "./shell"
+
+
+def run(script):
+    start = time.perf_counter()
+    subprocess.run([SHELL], input = f"source {script}\nexit\n".encode(), stdout = subprocess.DEVNULL, check = True)
+    return time.perf_counter() - start
+
+
+def main():
+    count = int(sys.argv[1]) if len(sys.argv) > 1 else 100000
+
+    for name, echo in (("/bin/echo", "/bin/echo"), ("builtin", "echo")):
+        with tempfile.NamedTemporaryFile("w", suffix = ".sh", delete = False) as script:
+            for i in range(count):
+                script.write(f"{echo} line {i} of the script\n")
+
+        try:
+            elapsed = run(script.name)
+            print(f"{name:>9}: {elapsed:8.3f}s for {count} lines ({elapsed / count * 1e6:8.2f}us per line)")
+        finally:
+            os.unlink(script.name)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+
+# Holds benchmark results (from bench/run_benchmarks.py) against a baseline, and flags every result which got worse by more
+# than the threshold. Exits with 1 if there is any regression, so it can gate a build.
+#
+# usage: python3 bench/compare.py baseline.json results.json [--threshold PERCENT]
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as source:
+        return json.load(source)
+
+
+def main():
+    parser = argparse.ArgumentParser(description = "Compares benchmark results against a baseline.")
+    parser.add_argument("baseline")
+    parser.add_argument("results")
+    parser.add_argument("--threshold", type = float, default = 10.0,
+                        help = "how much worse (in percent) a result may get before it counts as a regression")
+    args = parser.parse_args()
+
+    baseline, current = load(args.baseline), load(args.results)
+    if baseline.get("quick") != current.get("quick"):
+        print("warning: comparing a --quick run with a full one", file = sys.stderr)
+    if baseline.get("machine", {}).get("host") != current.get("machine", {}).get("host"):
+        print("warning: the baseline was taken on another machine", file = sys.stderr)
+
+    regressions = 0
+    print(f"{'benchmark':<34} {'baseline':>12} {'current':>12} {'change':>8}")
+    for name, result in current["results"].items():
+        before = baseline["results"].get(name)
+        if before is None or before["value"] == 0:
+            print(f"{name:<34} {'-':>12} {result['value']:>12.1f} {'new':>8}")
+            continue
+
+        change = (result["value"] - before["value"]) / before["value"] * 100
+        worse = -change if result["better"] == "higher" else change
+        flag = ""
+        if worse > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif worse < -args.threshold:
+            flag = "  improved"
+        print(f"{name:<34} {before['value']:>12.1f} {result['value']:>12.1f} {change:>+7.1f}% {result['unit']}{flag}")
+
+    for name in baseline["results"]:
+        if name not in current["results"]:
+            print(f"{name:<34} missing from the results")
+
+    print(f"\n{regressions} regression(s) over {args.threshold:g}%")
+    sys.exit(1 if regressions else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+
+# Measures the parallel builtin on CPU-bound runs (an awk busy loop per input), with 1, 2, 4, ... runs at once up to the number
+# of online CPUs, and prints the speedup over running them one at a time.
+#
+# usage: python3 bench/parallel_bench.py [inputs] [iterations]
+
+import os
+import subprocess
+import sys
+import time
+
+SHELL = "./shell"
+
+
+def run(jobs, inputs, iterations):
+    command = f'parallel -j {jobs} awk "BEGIN {{ for (i = 0; i < {iterations}; i++) s += i }}" ::: ' + " ".join(map(str, range(inputs)))
+    start = time.perf_counter()
+    subprocess.run([SHELL], input = f"{command}\nexit\n".encode(), stdout = subprocess.DEVNULL, check = True)
+    return time.perf_counter() - start
+
+
+def main():
+    inputs = int(sys.argv[1]) if len(sys.argv) > 1 else 32
+    iterations = int(sys.argv[2]) if len(sys.argv) > 2 else 2000000
+    cpus = os.cpu_count() or 1
+
+    counts = []
+    jobs = 1
+    while jobs < cpus:
+        counts.append(jobs)
+        jobs *= 2
+    counts.append(cpus)
+
+    baseline = None
+    for jobs in counts:
+        elapsed = run(jobs, inputs, iterations)
+        baseline = baseline or elapsed
+        print(f"-j {jobs:<3}: {elapsed:7.3f}s for {inputs} runs ({baseline / elapsed:4.2f}x)")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+
+# Measures the latency of short pipelines and redirections, with each spawn backend, against dash running the same lines.
+# A script of N copies of each command is sourced by ./shell (and run by dash), and the time per command is printed.
+#
+# usage: python3 bench/pipeline_bench.py [N]
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+SHELL = "./shell"
+BACKENDS = ["fork", "posix"]
+COMMANDS = [
+    "true | true",
+    "true | true | true",
+    "echo hi | cat > /dev/null",
+    "cat < /dev/null | cat | cat > /dev/null",
+]
+
+
+def run_shell(backend, script):
+    env = dict(os.environ, MINISHELL_SPAWN = backend)
+    start = time.perf_counter()
+    subprocess.run([SHELL], input = f"source {script}\nexit\n".encode(), stdout = subprocess.DEVNULL, env = env, check = True)
+    return time.perf_counter() - start
+
+
+def run_dash(script):
+    start = time.perf_counter()
+    subprocess.run(["dash", script], stdout = subprocess.DEVNULL, check = True)
+    return time.perf_counter() - start
+
+
+def main():
+    count = int(sys.argv[1]) if len(sys.argv) > 1 else 500
+    dash = shutil.which("dash") is not None
+
+    for command in COMMANDS:
+        with tempfile.NamedTemporaryFile("w", suffix = ".sh", delete = False) as script:
+            script.write(f"{command}\n" * count)
+
+        try:
+            results = [(backend, run_shell(backend, script.name)) for backend in BACKENDS]
+            if dash:
+                results.append(("dash", run_dash(script.name)))
+            timings = "  ".join(f"{name} {elapsed / count * 1e6:7.1f}us" for name, elapsed in results)
+            print(f"{command:<42} {timings}")
+        finally:
+            os.unlink(script.name)
+
+
+if __name__ == '__main__':
+    main()
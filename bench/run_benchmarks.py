@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+
+# Runs every benchmark of the shell and prints (or stores) the results as JSON, for bench/compare.py to hold against a baseline.
+# Nothing needs the network or anything beyond a stock Linux box: the inputs are generated, and only coreutils are launched.
+#
+#   tokenize.*   the tokenizer (each scanner, and create_tokens) over two generated corpora, in MB/s (bench/tokenize_bench)
+#   startup.*    the time from launching ./shell to its exit, interactive and with -c (next to dash, if it is installed)
+#   commands.*   commands run per second, for programs and for builtins
+#   pipeline.*   the throughput of `head -c ... /dev/zero` through N stages of cat, in MB/s
+#   copy.*       copying a file of a few GB to a file, through a pipe and through tee: inside the kernel by the shell, or by exec'd programs
+#   subst.*      handing the output of a command to another as its arguments: through $( ... ), or through a temporary file
+#   server.*     requests per second served by ./shell --server (through tools/shell_client, or straight over the socket), next to
+#                launching ./shell -c for each of them
+#   source.*     sourcing large scripts: cached, with the cache disabled, and one too large for the cache (run as it is mapped)
+#
+# Every measurement is repeated, and the best run is kept, as the noise on a busy machine only ever makes things slower.
+#
+# usage: python3 bench/run_benchmarks.py [--repeat N] [--quick] [--output results.json]
+
+import argparse
+import datetime
+import json
+import os
+import platform
+import shutil
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+SHELL = "./shell"
+CLIENT = "./tools/shell_client"
+TOKENIZE_BENCH = "./bench/tokenize_bench"
+
+
+def timed(command, stdin = b"", env = None):
+    """ runs a command to its end, returning how long it took (in seconds) """
+    start = time.perf_counter()
+    subprocess.run(command, input = stdin, stdout = subprocess.DEVNULL, stderr = subprocess.DEVNULL,
+                   env = dict(os.environ, **(env or {})), check = True)
+    return time.perf_counter() - start
+
+
+def timed_call(function):
+    """ calls a function, returning how long it took (in seconds) """
+    start = time.perf_counter()
+    function()
+    return time.perf_counter() - start
+
+
+def best(repeat, measure):
+    """ the fastest of a few runs of measure """
+    return min(measure() for _ in range(repeat))
+
+
+def bench_tokenize(results, repeat, quick):
+    runs = []
+    for _ in range(repeat):
+        output = subprocess.run([TOKENIZE_BENCH, "4" if quick else "16", "--json"], stdout = subprocess.PIPE, check = True)
+        runs.append(json.loads(output.stdout))
+
+    for corpus in ("commands", "file lists"):
+        for scanner in runs[0][corpus]:
+            name = f"tokenize.{corpus.replace(' ', '_')}.{scanner}"
+            results[name] = {"value": max(run[corpus][scanner] for run in runs), "unit": "MB/s", "better": "higher"}
+
+
+def bench_startup(results, repeat, quick):
+    samples = 20 if quick else 100
+
+    def median(command, stdin = b""):
+        return sorted(timed(command, stdin) for _ in range(samples))[samples // 2] * 1e3
+
+    # the prompt isn't flushed when stdout is a pipe, so the interactive shell is timed from its launch to its exit on `exit`
+    results["startup.exit"] = {"value": median([SHELL], b"exit\n"), "unit": "ms", "better": "lower"}
+
+    # sh -c with a builtin, and with a program (which the shell executes in its own place), next to dash doing the same
+    shells = [("shell", SHELL)] + ([("dash", shutil.which("dash"))] if shutil.which("dash") else [])
+    for name, path in shells:
+        for kind, command in (("builtin", "true"), ("program", "/bin/true")):
+            results[f"startup.{name}_c_{kind}"] = {"value": median([path, "-c", command]), "unit": "ms", "better": "lower"}
+
+
+def run_script(lines, env = None, repeats = 1):
+    """ sources a script of the given lines (repeats times in a row), returning how long the shell took """
+    with tempfile.NamedTemporaryFile("w", suffix = ".sh", delete = False) as script:
+        script.write("\n".join(lines) + "\n")
+    try:
+        return timed([SHELL], f"source {script.name}\n".encode() * repeats + b"exit\n", env)
+    finally:
+        os.unlink(script.name)
+
+
+def bench_commands(results, repeat, quick):
+    count = 200 if quick else 2000
+    for name, command in (("program", "/bin/true"), ("builtin", "true")):
+        elapsed = best(repeat, lambda: run_script([command] * count))
+        results[f"commands.{name}"] = {"value": count / elapsed, "unit": "commands/s", "better": "higher"}
+
+
+def bench_pipeline(results, repeat, quick):
+    megabytes = 64 if quick else 512
+    for stages in (1, 2, 4):
+        line = f"head -c {megabytes}M /dev/zero" + " | cat" * stages + " > /dev/null"
+        elapsed = best(repeat, lambda: run_script([line]))
+        results[f"pipeline.stages_{stages}"] = {"value": megabytes / elapsed, "unit": "MB/s", "better": "higher"}
+
+
+def bench_source(results, repeat, quick):
+    small = ["cd ."] * (2000 if quick else 20000)
+    large = ["cd ."] * (250000 if quick else 1000000) # over the 1 MB the script cache keeps
+    repeats = 5 if quick else 20
+
+    cases = (("cached", small, {}, repeats), ("uncached", small, {"MINISHELL_SOURCE_CACHE": "0"}, repeats),
+             ("mapped", large, {}, 1))
+    for name, lines, env, times in cases:
+        elapsed = best(repeat, lambda: run_script(lines, env, times))
+        results[f"source.{name}"] = {"value": len(lines) * times / elapsed, "unit": "lines/s", "better": "higher"}
+
+
+def bench_copy(results, repeat, quick):
+    # a file of a few GB (random data, so that nothing can skip over it), copied by the plain cat the shell runs itself, which
+    # copies inside the kernel, and by /bin/cat (a path, so it is always launched), and tee'd likewise
+    megabytes = 256 if quick else 2048
+    with tempfile.TemporaryDirectory() as directory:
+        source, copy = os.path.join(directory, "source"), os.path.join(directory, "copy")
+        block = os.urandom(1 << 20)
+        with open(source, "wb") as output:
+            for _ in range(megabytes):
+                output.write(block)
+
+        cases = (("file", "{cat} {source} > {copy}"),
+                 ("pipe", "{cat} {source} | {cat} > /dev/null"),
+                 ("tee", "{cat} {source} | {tee} {copy} | {cat} > /dev/null"))
+        for name, template in cases:
+            for kind, cat, tee in (("kernel", "cat", "tee"), ("exec", "/bin/cat", shutil.which("tee"))):
+                line = template.format(cat = cat, tee = tee, source = source, copy = copy)
+                elapsed = best(repeat, lambda: run_script([line]))
+                results[f"copy.{name}_{kind}"] = {"value": megabytes / elapsed, "unit": "MB/s", "better": "higher"}
+
+
+def bench_subst(results, repeat, quick):
+    # the words a command prints, handed to another one as its arguments: captured by $( ... ) in memory, or written to a temporary
+    # file which xargs reads back (the way it is done without substitutions); many small outputs, and a single large one
+    count = 200 if quick else 2000
+    numbers = 200000 if quick else 2000000
+    megabytes = sum(len(str(number)) + 1 for number in range(1, numbers + 1)) / (1 << 20)
+    with tempfile.TemporaryDirectory() as directory:
+        temporary = os.path.join(directory, "words")
+        cases = (("small_capture", ["echo $(echo some words) > /dev/null"] * count, count, "commands/s"),
+                 ("small_tempfile", [f"echo some words > {temporary}", f"xargs echo < {temporary} > /dev/null"] * count, count,
+                  "commands/s"),
+                 ("large_capture", [f"echo $(seq 1 {numbers}) > /dev/null"], megabytes, "MB/s"),
+                 ("large_tempfile", [f"seq 1 {numbers} > {temporary}", f"xargs echo < {temporary} > /dev/null"], megabytes, "MB/s"))
+        for name, lines, amount, unit in cases:
+            elapsed = best(repeat, lambda: run_script(lines))
+            results[f"subst.{name}"] = {"value": amount / elapsed, "unit": unit, "better": "higher"}
+
+
+def bench_server(results, repeat, quick):
+    # the same tasks (nothing at all, and sourcing a script of a few thousand lines) run by a fresh ./shell -c each, and by a
+    # worker of the server, which forks them from a zygote having the script parsed already
+    count = 50 if quick else 500
+    with tempfile.TemporaryDirectory() as directory:
+        path, script = os.path.join(directory, "socket"), os.path.join(directory, "script.sh")
+        with open(script, "w") as output:
+            output.write("true with a few words \"and a string\"\n" * 5000)
+
+        server = subprocess.Popen([SHELL, "--server", path, script])
+        try:
+            while not os.path.exists(path):
+                time.sleep(0.01)
+
+            def direct(commands):
+                """ sends a request over the socket as tools/shell_client does, with /dev/null for stdin, stdout and stderr """
+                data = commands.encode()
+                devnull = os.open(os.devnull, os.O_RDWR)
+                with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as conn:
+                    conn.connect(path)
+                    socket.send_fds(conn, [struct.pack("=II", 0x6d736831, len(data)) + data], [devnull] * 3)
+                    status = conn.recv(4)
+                os.close(devnull)
+                return status
+
+            for task, commands in (("true", "true"), ("source", f"source {script}")):
+                cases = (("spawn", lambda: timed([SHELL, "-c", commands])),
+                         ("client", lambda: timed([CLIENT, path, "-c", commands])),
+                         ("socket", lambda: timed_call(lambda: direct(commands))))
+                for name, run in cases:
+                    elapsed = best(repeat, lambda: sum(run() for _ in range(count)))
+                    results[f"server.{task}_{name}"] = {"value": count / elapsed, "unit": "requests/s", "better": "higher"}
+        finally:
+            server.terminate()
+            server.wait()
+
+
+def describe_machine():
+    commit = subprocess.run(["git", "rev-parse", "--short", "HEAD"], stdout = subprocess.PIPE, stderr = subprocess.DEVNULL)
+    return {
+        "date": datetime.datetime.now().isoformat(timespec = "seconds"),
+        "host": platform.node(),
+        "kernel": platform.release(),
+        "machine": platform.machine(),
+        "cpus": os.cpu_count(),
+        "python": platform.python_version(),
+        "commit": commit.stdout.decode().strip() or None,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description = "Runs the benchmarks of the shell.")
+    parser.add_argument("--repeat", type = int, default = 3, help = "how many times every measurement is taken (the best one counts)")
+    parser.add_argument("--quick", action = "store_true", help = "use smaller inputs, for checking that everything runs")
+    parser.add_argument("--output", help = "where to write the results (stdout by default)")
+    args = parser.parse_args()
+
+    os.environ["MINISHELL_HISTORY"] = "" # the lines the benchmarks enter never end up in anyone's history
+    results = {}
+    for bench in (bench_tokenize, bench_startup, bench_commands, bench_pipeline, bench_copy, bench_subst, bench_server, bench_source):
+        print(f"running {bench.__name__[6:]} ...", file = sys.stderr)
+        bench(results, args.repeat, args.quick)
+
+    report = {"machine": describe_machine(), "quick": args.quick, "results": results}
+    text = json.dumps(report, indent = 2) + "\n"
+    if args.output:
+        with open(args.output, "w") as output:
+            output.write(text)
+        print(f"results written to {args.output}", file = sys.stderr)
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == '__main__':
+    main()
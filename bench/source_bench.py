@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+
+# Measures repeated `source` calls of the same script, with the script cache enabled and disabled (MINISHELL_SOURCE_CACHE=0).
+# The script only runs `cd .` builtins, so that the time goes into reading and parsing it rather than into launching programs.
+#
+# usage: python3 bench/source_bench.py [lines] [repeats]
+
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+SHELL = "./shell"
+
+
+def run(cache, script, repeats):
+    env = dict(os.environ, MINISHELL_SOURCE_CACHE = "1" if cache else "0")
+    commands = f"source {script}\n" * repeats + "exit\n"
+    start = time.perf_counter()
+    subprocess.run([SHELL], input = commands.encode(), stdout = subprocess.DEVNULL, env = env, check = True)
+    return time.perf_counter() - start
+
+
+def main():
+    lines = int(sys.argv[1]) if len(sys.argv) > 1 else 20000
+    repeats = int(sys.argv[2]) if len(sys.argv) > 2 else 50
+
+    with tempfile.NamedTemporaryFile("w", suffix = ".sh", delete = False) as script:
+        for i in range(lines):
+            script.write(f'cd . ; cd "." ;cd   .   ; cd ./ \n' if i % 2 else "cd .\n")
+
+    try:
+        for cache in (False, True):
+            elapsed = run(cache, script.name, repeats)
+            name = "cached" if cache else "uncached"
+            print(f"{name:>8}: {repeats / elapsed:8.1f} sources/s ({repeats} x {lines} lines in {elapsed:.3f}s)")
+    finally:
+        os.unlink(script.name)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+
+# Measures sourcing one large script (100 MB by default), once as a regular file (mapped into memory and parsed in one go)
+# and once through a FIFO (read line by line with getline), with the script cache disabled so that every run parses it.
+# Every line is a `cd .` builtin followed by a few kilobytes of arguments it ignores, so that the time goes into reading and
+# tokenizing the script rather than into running it.
+#
+# usage: python3 bench/source_large_bench.py [megabytes]
+
+import os
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+SHELL = "./shell"
+LINE = "cd . " + " ".join(f'"quoted {i}" arg{i} file-{i}.txt' for i in range(64)) + "\n"
+
+
+def run(path):
+    env = dict(os.environ, MINISHELL_SOURCE_CACHE = "0")
+    start = time.perf_counter()
+    subprocess.run([SHELL], input = f"source {path}\nexit\n".encode(), stdout = subprocess.DEVNULL, env = env, check = True)
+    return time.perf_counter() - start
+
+
+def feed(script, fifo):
+    with open(script, "rb") as source, open(fifo, "wb") as sink:
+        while chunk := source.read(1 << 20):
+            sink.write(chunk)
+
+
+def main():
+    megabytes = int(sys.argv[1]) if len(sys.argv) > 1 else 100
+    lines = megabytes * (1 << 20) // len(LINE)
+
+    with tempfile.TemporaryDirectory() as directory:
+        script = os.path.join(directory, "large.sh")
+        with open(script, "w") as out:
+            block = LINE * 1024
+            for _ in range(lines // 1024):
+                out.write(block)
+            out.write(LINE * (lines % 1024))
+        size = os.path.getsize(script) / (1 << 20)
+
+        elapsed = run(script)
+        print(f"  mapped: {size / elapsed:8.1f} MB/s ({size:.0f} MB, {lines} lines in {elapsed:.3f}s)")
+
+        fifo = os.path.join(directory, "large.fifo")
+        os.mkfifo(fifo)
+        writer = threading.Thread(target = feed, args = (script, fifo))
+        writer.start()
+        elapsed = run(fifo)
+        writer.join()
+        print(f"streamed: {size / elapsed:8.1f} MB/s ({size:.0f} MB, {lines} lines in {elapsed:.3f}s)")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+
+# Measures how many commands per second the shell launches with each spawn backend.
+# A script of N `true` lines is sourced by ./shell once per backend (selected with MINISHELL_SPAWN).
+#
+# usage: python3 bench/spawn_bench.py [N]
+
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+SHELL = "./shell"
+BACKENDS = ["fork", "posix"]
+
+
+def run(backend, script):
+    env = dict(os.environ, MINISHELL_SPAWN = backend)
+    start = time.perf_counter()
+    subprocess.run([SHELL], input = f"source {script}\nexit\n".encode(),
+                   stdout = subprocess.DEVNULL, env = env, check = True)
+    return time.perf_counter() - start
+
+
+def main():
+    count = int(sys.argv[1]) if len(sys.argv) > 1 else 2000
+
+    with tempfile.NamedTemporaryFile("w", suffix = ".sh", delete = False) as script:
+        script.write("true\n" * count)
+
+    try:
+        for backend in BACKENDS:
+            elapsed = run(backend, script.name)
+            print(f"{backend:>6}: {count / elapsed:10.1f} commands/s ({count} commands in {elapsed:.3f}s)")
+    finally:
+        os.unlink(script.name)
+
+
+if __name__ == '__main__':
+    main()
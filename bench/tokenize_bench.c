@@ -0,0 +1,262 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// Measures the throughput of the tokenizer, in MB/s, over two corpora of generated command lines (short commands joined by
+// pipes and redirections, and commands taking long lists of files), once for every scanner the CPU supports (byte-by-byte,
+// SSE2 and AVX2), and checks that all of them give exactly the same tokens. create_tokens (which allocates a fresh array for
+// every line) is measured as well, with the best scanner.
+// With --json, the results are printed as a single JSON object instead (for bench/run_benchmarks.py).
+//
+// usage: ./bench/tokenize_bench [corpus size in MB] [--json]
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+// ************** Including the necessary header file **************
+
+#include "../tokens.h"
+
+// ************** Define global variables **************
+
+static const char *commands[] = {"ls", "cat", "grep", "make", "echo", "find", "sort", "uniq", "wc", "git", "cp", "tar", "sed", "awk"};
+static const char *flags[] = {"-l", "-la", "-n", "-rn", "--color=auto", "-j8", "-c", "--oneline", "-name", "-print0", "-xzf"};
+static const char *words[] = {"/usr/local/bin", "src/tokens.c", "build/output.log", "README.md", "/var/log/syslog",
+                              "\"hello world\"", "\"*.c\"", "'TODO'", "data/2024-01-01/records.csv", "main", "HEAD~3"};
+static const char *operators[] = {" | ", " > ", " < ", "; ", " & ", " | ", " | "};
+
+// ************** Defining the helpers **************
+
+static const char *directories[] = {"/home/builder/projects/shell/build/objects", "src/generated/protocol",
+                                    "/var/cache/artifacts/2024-01-01", "third_party/libraries/include/detail"};
+
+static uint64_t next_random(uint64_t *state)
+{
+  *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *state >> 33;
+}
+
+static int json = 0; // whether the results are printed as JSON
+
+#define PICK(array, state) array[next_random(state) % (sizeof(array) / sizeof(array[0]))]
+
+// appending a realistic command line (a few commands with flags and arguments, joined by pipes, redirections or ;)
+
+static size_t make_line(uint64_t *state, char *line)
+{
+  size_t len = 0;
+  int stages = 1 + next_random(state) % 4;
+
+  for (int stage = 0; stage < stages; ++stage)
+  {
+    len += sprintf(&line[len], "%s", PICK(commands, state));
+    int args = next_random(state) % 6;
+    for (int arg = 0; arg < args; ++arg)
+    {
+      len += sprintf(&line[len], " %s", (next_random(state) % 3 == 0) ? PICK(flags, state) : PICK(words, state));
+    }
+    if (stage + 1 < stages)
+    {
+      len += sprintf(&line[len], "%s", PICK(operators, state));
+    }
+  }
+  line[len++] = '\n';
+  return len;
+}
+
+// appending a command taking a long list of files, as generated by our build scripts
+
+static size_t make_file_list_line(uint64_t *state, char *line)
+{
+  size_t len = sprintf(line, "tar -czf \"backup of %d.tar.gz\"", (int)(next_random(state) % 1000));
+  int files = 10 + next_random(state) % 40;
+
+  for (int file = 0; file < files; ++file)
+  {
+    len += sprintf(&line[len], " %s/module_%04d/source_file_%06d.o", PICK(directories, state),
+                   (int)(next_random(state) % 10000), (int)(next_random(state) % 1000000));
+  }
+  len += sprintf(&line[len], " > archive.log\n");
+  return len;
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// tokenizing every line of the corpus, returning a hash of all the tokens (FNV-1a over each token and its end) if asked to
+// (the hash is left out of the timed runs, as it costs far more than the tokenizer itself)
+
+static uint64_t run(tokenizer_t *ctx, const char *corpus, const size_t *offsets, size_t num_lines, int with_hash)
+{
+  uint64_t hash = 14695981039346656037ULL;
+
+  for (size_t line = 0; line < num_lines; ++line)
+  {
+    char **tokens = tokenize_into(ctx, &corpus[offsets[line]], offsets[line + 1] - offsets[line]);
+    for (; with_hash && *tokens != NULL; ++tokens)
+    {
+      for (const char *c = *tokens; *c; ++c)
+      {
+        hash = (hash ^ (unsigned char)*c) * 1099511628211ULL;
+      }
+      hash = (hash ^ 0xff) * 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+// getting the tokens of every line with create_tokens (the lines of lines are each followed by a \0), freeing them right away
+
+static size_t run_create_tokens(const char *lines, const size_t *offsets, size_t num_lines)
+{
+  size_t total = 0;
+
+  for (size_t line = 0; line < num_lines; ++line)
+  {
+    char **tokens = create_tokens(&lines[offsets[line]]);
+    total += (tokens[0] != NULL);
+    free_tokens(tokens);
+  }
+  return total;
+}
+
+// printing the throughput of one way of tokenizing the corpus
+
+static void report(const char *scanner, size_t bytes, double elapsed, int first, const char *note)
+{
+  if (json)
+  {
+    printf("%s\"%s\": %.1f", first ? "" : ", ", scanner, bytes / 1048576.0 / elapsed);
+  }
+  else
+  {
+    printf("  %-13s %8.1f MB/s%s\n", scanner, bytes / 1048576.0 / elapsed, note);
+  }
+}
+
+// ************** Defining the main function **************
+
+// generating a corpus of about size bytes and measuring every scanner on it, returns whether any of them disagreed
+
+static int bench_corpus(const char *name, size_t (*generate)(uint64_t *, char *), size_t size)
+{
+  // generating the corpus as one buffer, with the offset at which every line starts
+  char *corpus = malloc(size + 8192);
+  size_t max_lines = size / 8 + 2;
+  size_t *offsets = malloc(sizeof(size_t) * max_lines);
+  size_t num_lines = 0;
+  size_t used = 0;
+  uint64_t state = 42;
+
+  while (used < size && num_lines + 1 < max_lines)
+  {
+    offsets[num_lines++] = used;
+    used += generate(&state, &corpus[used]);
+  }
+  offsets[num_lines] = used;
+
+  tokenizer_t ctx;
+  tokenizer_init(&ctx);
+  unsigned char best = ctx.scan_width;
+  unsigned char widths[] = {0, 16, 32};
+  uint64_t reference = 0;
+  int mismatch = 0;
+
+  if (json)
+  {
+    printf("\"%s\": {", name);
+  }
+  else
+  {
+    printf("%s: %zu lines, %.1f MB\n", name, num_lines, used / 1048576.0);
+  }
+
+  for (size_t index = 0; index < sizeof(widths); ++index)
+  {
+    if (widths[index] > best)
+    {
+      continue;
+    }
+    ctx.scan_width = widths[index];
+
+    uint64_t hash = run(&ctx, corpus, offsets, num_lines, 1); // also warming up the arena and the caches
+    double start = now();
+    run(&ctx, corpus, offsets, num_lines, 0);
+    double elapsed = now() - start;
+
+    if (index == 0)
+    {
+      reference = hash;
+    }
+    mismatch |= (hash != reference);
+
+    report(widths[index] == 0 ? "scalar" : widths[index] == 16 ? "sse2" : "avx2", used, elapsed, index == 0,
+           hash == reference ? "" : "  (tokens differ from the scalar scanner!)");
+  }
+
+  // create_tokens needs a \0 at the end of every line, which takes the place of its \n (where a token ends anyway)
+  char *lines = malloc(used);
+  for (size_t index = 0; index < used; ++index)
+  {
+    lines[index] = (corpus[index] == '\n') ? '\0' : corpus[index];
+  }
+  run_create_tokens(lines, offsets, num_lines);
+  double start = now();
+  run_create_tokens(lines, offsets, num_lines);
+  report("create_tokens", used, now() - start, 0, "");
+  free(lines);
+
+  if (json)
+  {
+    printf("}");
+  }
+
+  tokenizer_free(&ctx);
+  free(offsets);
+  free(corpus);
+  return mismatch;
+}
+
+int main(int argc, char **argv)
+{
+  size_t size = (size_t)64 << 20;
+  int mismatch = 0;
+
+  for (int arg = 1; arg < argc; ++arg)
+  {
+    if (strcmp(argv[arg], "--json") == 0)
+    {
+      json = 1;
+    }
+    else
+    {
+      size = (size_t)atoi(argv[arg]) << 20;
+    }
+  }
+
+  if (json)
+  {
+    printf("{");
+  }
+  mismatch |= bench_corpus("commands", make_line, size);
+  if (json)
+  {
+    printf(", ");
+  }
+  mismatch |= bench_corpus("file lists", make_file_list_line, size);
+  if (json)
+  {
+    printf(", \"mismatch\": %s}\n", mismatch ? "true" : "false");
+  }
+
+  return mismatch;
+}
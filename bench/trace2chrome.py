@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+
+# Turns a trace written by the shell (MINISHELL_TRACE=trace.jsonl ./shell) into the Chrome trace-event format, which can be
+# opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+# The line, tokenize, command and run events become nested slices on the shell's track (sepCommmand -> manageShell -> the
+# command being run), each fork/exec pair a spawn slice, and every child a slice of its own track, from its launch to its reaping.
+#
+# usage: python3 bench/trace2chrome.py trace.jsonl [trace.json]
+
+import json
+import sys
+
+# the events coming in pairs, and the slice they become
+SLICES = {"line": "line", "tokenize": "tokenize", "command": "command", "run": "run"}
+
+# the events which are only shown as a point in time
+INSTANTS = {"line_read", "redirect_open", "pipe_create", "dropped"}
+
+
+def micros(ns):
+    return ns / 1000.0
+
+
+def convert(records):
+    events = []
+    children = {}    # pid -> (launched at, name), for the children which haven't been reaped yet
+    fork = None      # the fork waiting for its exec
+    shell_pid = None
+
+    for record in records:
+        kind, ts = record["event"], record["ts"]
+        pid = record["pid"]
+        name = record.get("name") or ""
+        shell_pid = pid
+        base = {"pid": pid, "tid": pid, "ts": micros(ts)}
+
+        prefix, _, edge = kind.rpartition("_")
+        if prefix in SLICES and edge in ("begin", "end"):
+            event = dict(base, ph = "B" if edge == "begin" else "E")
+            if edge == "begin":
+                event["name"] = f"{SLICES[prefix]} {name}".strip()
+                event["args"] = {"argv": record["argv"], "value": record["value"]}
+            events.append(event)
+        elif kind == "fork":
+            fork = record
+        elif kind == "exec":
+            start = fork["ts"] if fork is not None else ts
+            events.append(dict(base, ph = "X", ts = micros(start), dur = micros(ts - start), name = f"spawn {name}",
+                               args = {"argv": record["argv"], "child": record["child"], "errno": record["value"]}))
+            fork = None
+            if record["child"] > 0:
+                children[record["child"]] = (ts, name)
+        elif kind == "child_exit":
+            child = record["child"]
+            start, child_name = children.pop(child, (ts, "?"))
+            events.append({"pid": pid, "tid": child, "ph": "X", "ts": micros(start), "dur": micros(ts - start),
+                           "name": f"{child_name} ({child})", "args": {"status": record["value"]}})
+            events.append({"pid": pid, "tid": child, "ph": "M", "name": "thread_name",
+                           "args": {"name": f"child {child} ({child_name})"}})
+        elif kind in INSTANTS:
+            events.append(dict(base, ph = "i", s = "t", name = kind,
+                               args = {key: record[key] for key in ("argv", "name", "child", "value") if key in record}))
+
+    if shell_pid is not None:
+        events.append({"pid": shell_pid, "tid": shell_pid, "ph": "M", "name": "thread_name", "args": {"name": "shell"}})
+        events.append({"pid": shell_pid, "ph": "M", "name": "process_name", "args": {"name": f"mini-shell ({shell_pid})"}})
+    return {"traceEvents": events, "displayTimeUnit": "ns"}
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(f"usage: {sys.argv[0]} trace.jsonl [trace.json]", file = sys.stderr)
+        sys.exit(2)
+
+    with open(sys.argv[1]) as source:
+        records = [json.loads(line) for line in source if line.strip()]
+
+    output = open(sys.argv[2], "w") if len(sys.argv) > 2 else sys.stdout
+    json.dump(convert(records), output)
+    output.write("\n")
+
+
+if __name__ == '__main__':
+    main()
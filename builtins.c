@@ -0,0 +1,603 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// ************** Including the necessary header file **************
+
+#include "builtins.h"
+#include "copy.h" // for copying the data of cat and tee inside the kernel
+
+// ************** Declaring helper functions **************
+
+static int put_escape(const char **cursor, int zero_octal);
+static int test_unary(const char *op, const char *arg);
+static int test_binary(const char *left, const char *op, const char *right);
+static int test_eval(int argc, char *const *args);
+static int parse_integer(const char *text, long long *value);
+static int printf_number(const char *arg, long long *value);
+static int printf_once(const char *format, char *const **args, int *status);
+
+// ************** Shared helpers **************
+
+// printing the escape sequence starting at the backslash at *cursor, and moving the cursor past it
+// octal escapes are \0NNN if zero_octal is set (echo -e and %b), \NNN otherwise (the format of printf)
+// returns 1 for \c, after which nothing else is printed
+
+static int put_escape(const char **cursor, int zero_octal)
+{
+  const char *p = *cursor + 1; // the character after the backslash
+  int value;
+
+  switch (*p)
+  {
+  case 'a': value = '\a'; p++; break;
+  case 'b': value = '\b'; p++; break;
+  case 'e': value = 27; p++; break;
+  case 'f': value = '\f'; p++; break;
+  case 'n': value = '\n'; p++; break;
+  case 'r': value = '\r'; p++; break;
+  case 't': value = '\t'; p++; break;
+  case 'v': value = '\v'; p++; break;
+  case '\\': value = '\\'; p++; break;
+  case 'c':
+    *cursor = p + 1;
+    return 1;
+  case 'x':
+    if (!((p[1] >= '0' && p[1] <= '9') || (p[1] >= 'a' && p[1] <= 'f') || (p[1] >= 'A' && p[1] <= 'F')))
+    {
+      value = '\\'; // not an escape after all
+      break;
+    }
+    value = 0;
+    p++;
+    for (int digits = 0; digits < 2; ++digits, ++p)
+    {
+      if (*p >= '0' && *p <= '9')
+        value = value * 16 + (*p - '0');
+      else if (*p >= 'a' && *p <= 'f')
+        value = value * 16 + (*p - 'a' + 10);
+      else if (*p >= 'A' && *p <= 'F')
+        value = value * 16 + (*p - 'A' + 10);
+      else
+        break;
+    }
+    break;
+  default:
+    if (*p >= '0' && *p <= '7' && (!zero_octal || *p == '0'))
+    {
+      if (zero_octal)
+      {
+        p++; // the 0 doesn't count towards the 3 digits
+      }
+      value = 0;
+      for (int digits = 0; digits < 3 && *p >= '0' && *p <= '7'; ++digits, ++p)
+      {
+        value = value * 8 + (*p - '0');
+      }
+      break;
+    }
+    value = '\\'; // an unknown escape is printed as it is
+    break;
+  }
+
+  putchar(value & 0xff);
+  *cursor = p;
+  return 0;
+}
+
+// ************** echo, true, false, pwd **************
+
+// printing the arguments, separated by spaces
+
+int builtin_echo(char *const *argv)
+{
+  int newline = 1;
+  int escapes = 0;
+  int index = 1;
+
+  // just like /bin/echo, the leading arguments made of nothing but n, e and E (after a -) are options
+  for (; argv[index] != NULL && argv[index][0] == '-' && argv[index][1] != '\0'; ++index)
+  {
+    if (strspn(&argv[index][1], "neE") != strlen(&argv[index][1]))
+    {
+      break;
+    }
+    for (const char *option = &argv[index][1]; *option != '\0'; ++option)
+    {
+      if (*option == 'n')
+        newline = 0;
+      else
+        escapes = (*option == 'e');
+    }
+  }
+
+  for (int first = index; argv[index] != NULL; ++index)
+  {
+    if (index > first)
+    {
+      putchar(' ');
+    }
+    if (!escapes)
+    {
+      fputs(argv[index], stdout);
+      continue;
+    }
+    for (const char *p = argv[index]; *p != '\0';)
+    {
+      if (*p != '\\' || p[1] == '\0')
+      {
+        putchar(*p++);
+      }
+      else if (put_escape(&p, 1))
+      {
+        return 0;
+      }
+    }
+  }
+
+  if (newline)
+  {
+    putchar('\n');
+  }
+  return 0;
+}
+
+// doing nothing, successfully
+
+int builtin_true(char *const *argv)
+{
+  (void)argv;
+  return 0;
+}
+
+// doing nothing, unsuccessfully
+
+int builtin_false(char *const *argv)
+{
+  (void)argv;
+  return 1;
+}
+
+// printing the current working directory
+
+int builtin_pwd(char *const *argv)
+{
+  (void)argv;
+  char *cwd = getcwd(NULL, 0);
+  if (cwd == NULL)
+  {
+    perror("pwd");
+    return 1;
+  }
+  puts(cwd);
+  free(cwd);
+  return 0;
+}
+
+// ************** cat and tee **************
+
+// copying each file (or stdin, for none or -) to stdout
+
+int builtin_cat(char *const *argv)
+{
+  fflush(stdout); // the data goes straight to the descriptor, after whatever was printed before
+  int status = 0;
+
+  // with no files, stdin is copied
+  char *const *paths = (argv[1] != NULL) ? &argv[1] : (char *const[]){"-", NULL};
+  for (; *paths != NULL; ++paths)
+  {
+    int fd = (strcmp(*paths, "-") == 0) ? 0 : open(*paths, O_RDONLY | O_CLOEXEC);
+    if (fd == -1 || copy_fd(fd, 1) == -1)
+    {
+      fprintf(stderr, "cat: %s: %s\n", *paths, strerror(errno));
+      status = 1;
+    }
+    if (fd > 0)
+    {
+      close(fd);
+    }
+  }
+  return status;
+}
+
+// copying stdin to stdout and to each of the files
+
+int builtin_tee(char *const *argv)
+{
+  fflush(stdout);
+  int append = (argv[1] != NULL && strcmp(argv[1], "-a") == 0);
+  char *const *paths = &argv[1 + append];
+  int status = 0;
+
+  int num_paths = 0;
+  while (paths[num_paths] != NULL)
+  {
+    num_paths++;
+  }
+  int *files = malloc(sizeof(int) * (num_paths + 1));
+  if (files == NULL)
+  {
+    perror("tee");
+    return 1;
+  }
+
+  int num_files = 0;
+  for (int index = 0; index < num_paths; ++index)
+  {
+    int fd = open(paths[index], O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+    if (fd == -1)
+    {
+      fprintf(stderr, "tee: %s: %s\n", paths[index], strerror(errno));
+      status = 1;
+      continue;
+    }
+    files[num_files++] = fd;
+  }
+
+  if (tee_fd(0, 1, files, num_files) == -1)
+  {
+    perror("tee");
+    status = 1;
+  }
+
+  for (int index = 0; index < num_files; ++index)
+  {
+    close(files[index]);
+  }
+  free(files);
+  return status;
+}
+
+// ************** test **************
+
+// reading an integer operand of test; returns -1 if it isn't one
+
+static int parse_integer(const char *text, long long *value)
+{
+  char *end;
+  errno = 0;
+  *value = strtoll(text, &end, 10);
+  while (*end == ' ' || *end == '\t')
+  {
+    end++;
+  }
+  if (end == text || *end != '\0' || errno != 0)
+  {
+    fprintf(stderr, "test: %s: integer expression expected\n", text);
+    return -1;
+  }
+  return 0;
+}
+
+// evaluating a unary operator (returns 0 for true, 1 for false, and 2 if op isn't a unary operator)
+
+static int test_unary(const char *op, const char *arg)
+{
+  struct stat info;
+
+  if (op[0] != '-' || op[1] == '\0' || op[2] != '\0')
+  {
+    return 2;
+  }
+
+  switch (op[1])
+  {
+  case 'n': return arg[0] != '\0' ? 0 : 1;
+  case 'z': return arg[0] == '\0' ? 0 : 1;
+  case 'e': return stat(arg, &info) == 0 ? 0 : 1;
+  case 'f': return stat(arg, &info) == 0 && S_ISREG(info.st_mode) ? 0 : 1;
+  case 'd': return stat(arg, &info) == 0 && S_ISDIR(info.st_mode) ? 0 : 1;
+  case 'b': return stat(arg, &info) == 0 && S_ISBLK(info.st_mode) ? 0 : 1;
+  case 'c': return stat(arg, &info) == 0 && S_ISCHR(info.st_mode) ? 0 : 1;
+  case 'p': return stat(arg, &info) == 0 && S_ISFIFO(info.st_mode) ? 0 : 1;
+  case 'S': return stat(arg, &info) == 0 && S_ISSOCK(info.st_mode) ? 0 : 1;
+  case 's': return stat(arg, &info) == 0 && info.st_size > 0 ? 0 : 1;
+  case 'h':
+  case 'L': return lstat(arg, &info) == 0 && S_ISLNK(info.st_mode) ? 0 : 1;
+  case 'r': return access(arg, R_OK) == 0 ? 0 : 1;
+  case 'w': return access(arg, W_OK) == 0 ? 0 : 1;
+  case 'x': return access(arg, X_OK) == 0 ? 0 : 1;
+  case 't': return isatty(atoi(arg)) ? 0 : 1;
+  default: return 2;
+  }
+}
+
+// evaluating a binary operator (returns 0 for true, 1 for false, 2 if an operand is wrong and 3 if op isn't a binary operator)
+
+static int test_binary(const char *left, const char *op, const char *right)
+{
+  if (strcmp(op, "=") == 0 || strcmp(op, "==") == 0)
+  {
+    return strcmp(left, right) == 0 ? 0 : 1;
+  }
+  if (strcmp(op, "!=") == 0)
+  {
+    return strcmp(left, right) != 0 ? 0 : 1;
+  }
+
+  static const char *const integer_ops[] = {"-eq", "-ne", "-lt", "-le", "-gt", "-ge"};
+  for (int index = 0; index < 6; ++index)
+  {
+    if (strcmp(op, integer_ops[index]) != 0)
+    {
+      continue;
+    }
+
+    long long a, b;
+    if (parse_integer(left, &a) == -1 || parse_integer(right, &b) == -1)
+    {
+      return 2;
+    }
+    int results[] = {a == b, a != b, a < b, a <= b, a > b, a >= b};
+    return results[index] ? 0 : 1;
+  }
+
+  if (strcmp(op, "-nt") == 0 || strcmp(op, "-ot") == 0 || strcmp(op, "-ef") == 0)
+  {
+    struct stat a, b;
+    int has_a = stat(left, &a) == 0;
+    int has_b = stat(right, &b) == 0;
+
+    if (op[1] == 'e')
+    {
+      return has_a && has_b && a.st_dev == b.st_dev && a.st_ino == b.st_ino ? 0 : 1;
+    }
+
+    // a file which exists is newer than one which doesn't
+    int newer = has_a && (!has_b || a.st_mtim.tv_sec > b.st_mtim.tv_sec ||
+                          (a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec > b.st_mtim.tv_nsec));
+    int older = has_b && (!has_a || b.st_mtim.tv_sec > a.st_mtim.tv_sec ||
+                          (b.st_mtim.tv_sec == a.st_mtim.tv_sec && b.st_mtim.tv_nsec > a.st_mtim.tv_nsec));
+    return (op[1] == 'n' ? newer : older) ? 0 : 1;
+  }
+
+  return 3;
+}
+
+// evaluating an expression of argc arguments, following the POSIX rules for up to 4 arguments
+
+static int test_eval(int argc, char *const *args)
+{
+  int result;
+
+  switch (argc)
+  {
+  case 0:
+    return 1;
+  case 1:
+    return args[0][0] != '\0' ? 0 : 1;
+  case 2:
+    if (strcmp(args[0], "!") == 0)
+    {
+      result = test_eval(1, &args[1]);
+      return result == 2 ? 2 : !result;
+    }
+    result = test_unary(args[0], args[1]);
+    if (result == 2)
+    {
+      fprintf(stderr, "test: %s: unary operator expected\n", args[0]);
+    }
+    return result;
+  case 3:
+    result = test_binary(args[0], args[1], args[2]);
+    if (result != 3)
+    {
+      return result;
+    }
+    if (strcmp(args[0], "!") == 0)
+    {
+      result = test_eval(2, &args[1]);
+      return result == 2 ? 2 : !result;
+    }
+    if (strcmp(args[0], "(") == 0 && strcmp(args[2], ")") == 0)
+    {
+      return test_eval(1, &args[1]);
+    }
+    fprintf(stderr, "test: %s: binary operator expected\n", args[1]);
+    return 2;
+  case 4:
+    if (strcmp(args[0], "!") == 0)
+    {
+      result = test_eval(3, &args[1]);
+      return result == 2 ? 2 : !result;
+    }
+    if (strcmp(args[0], "(") == 0 && strcmp(args[3], ")") == 0)
+    {
+      return test_eval(2, &args[1]);
+    }
+    break;
+  }
+
+  fprintf(stderr, "test: too many arguments\n");
+  return 2;
+}
+
+// evaluating the expression given to test, or to [ (which has to end with a ])
+
+int builtin_test(char *const *argv)
+{
+  int argc = 0;
+  while (argv[argc + 1] != NULL)
+  {
+    argc++;
+  }
+
+  if (strcmp(argv[0], "[") == 0)
+  {
+    if (argc == 0 || strcmp(argv[argc], "]") != 0)
+    {
+      fprintf(stderr, "[: missing ]\n");
+      return 2;
+    }
+    argc--;
+  }
+
+  return test_eval(argc, &argv[1]);
+}
+
+// ************** printf **************
+
+// reading a numeric argument of printf ('c or "c stands for the code of c); sets status to 1 if it isn't a number
+
+static int printf_number(const char *arg, long long *value)
+{
+  if (arg[0] == '\'' || arg[0] == '"')
+  {
+    *value = (unsigned char)arg[1];
+    return 0;
+  }
+
+  char *end;
+  errno = 0;
+  *value = strtoll(arg, &end, 0);
+  if (*arg == '\0')
+  {
+    return 0; // an empty argument is 0
+  }
+  if (end == arg || *end != '\0' || errno != 0)
+  {
+    fprintf(stderr, "printf: %s: invalid number\n", arg);
+    return -1;
+  }
+  return 0;
+}
+
+// printing the format once, taking the arguments it needs from *args (missing ones being empty or 0)
+// returns 1 if \c (or %b with \c) stopped all output
+
+static int printf_once(const char *format, char *const **args, int *status)
+{
+  for (const char *p = format; *p != '\0';)
+  {
+    if (*p == '\\' && p[1] != '\0')
+    {
+      if (put_escape(&p, 0))
+      {
+        return 1;
+      }
+      continue;
+    }
+    if (*p != '%')
+    {
+      putchar(*p++);
+      continue;
+    }
+    if (p[1] == '%')
+    {
+      putchar('%');
+      p += 2;
+      continue;
+    }
+
+    // copying the flags, width and precision of the directive, taking * from the arguments
+    char spec[64] = "%";
+    size_t spec_len = 1;
+    const char *start = p++;
+    while (*p != '\0' && strchr("-+ #0123456789.*", *p) != NULL && spec_len < sizeof(spec) - 24)
+    {
+      if (*p == '*')
+      {
+        long long width = 0;
+        if (**args != NULL && printf_number(*(*args)++, &width) == -1)
+        {
+          *status = 1;
+        }
+        spec_len += snprintf(&spec[spec_len], sizeof(spec) - spec_len, "%d", (int)width);
+      }
+      else
+      {
+        spec[spec_len++] = *p;
+      }
+      p++;
+    }
+    spec[spec_len] = '\0';
+
+    const char *arg = (**args != NULL) ? *(*args)++ : NULL;
+    long long number = 0;
+
+    switch (*p)
+    {
+    case 'd':
+    case 'i':
+      if (arg != NULL && printf_number(arg, &number) == -1)
+        *status = 1;
+      strcat(spec, "lld");
+      printf(spec, number);
+      break;
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+      if (arg != NULL && printf_number(arg, &number) == -1)
+        *status = 1;
+      spec[spec_len] = 'l';
+      spec[spec_len + 1] = 'l';
+      spec[spec_len + 2] = *p;
+      spec[spec_len + 3] = '\0';
+      printf(spec, (unsigned long long)number);
+      break;
+    case 'c':
+      strcat(spec, "c");
+      printf(spec, arg != NULL ? arg[0] : '\0');
+      break;
+    case 's':
+      strcat(spec, "s");
+      printf(spec, arg != NULL ? arg : "");
+      break;
+    case 'b':
+      for (const char *b = (arg != NULL) ? arg : ""; *b != '\0';)
+      {
+        if (*b != '\\' || b[1] == '\0')
+        {
+          putchar(*b++);
+        }
+        else if (put_escape(&b, 1))
+        {
+          return 1;
+        }
+      }
+      break;
+    default:
+      fprintf(stderr, "printf: %.*s: invalid directive\n", (int)(p - start + (*p != '\0')), start);
+      *status = 1;
+      return 1;
+    }
+    p++;
+  }
+  return 0;
+}
+
+// printing the arguments through the format, reusing it for as long as some are left (and it takes any)
+
+int builtin_printf(char *const *argv)
+{
+  if (argv[1] == NULL)
+  {
+    fprintf(stderr, "usage: printf format [arguments ...]\n");
+    return 2;
+  }
+
+  int status = 0;
+  char *const *args = &argv[2];
+
+  while (1)
+  {
+    char *const *before = args;
+    if (printf_once(argv[1], &args, &status) || *args == NULL || args == before)
+    {
+      break;
+    }
+  }
+  return status;
+}
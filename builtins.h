@@ -0,0 +1,37 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _BUILTINS_H
+#define _BUILTINS_H
+
+// the utilities the shell runs itself rather than launching a program for them
+// each of them takes the arguments a program would get (argv[0] being its name), writes to stdout/stderr, and returns the exit
+// status the program would have. they only ever use the standard descriptors, so the shell can run them in its own process
+// (with the descriptors swapped around for a redirection) or in a child (as a stage of a pipeline).
+
+// echo [-neE] [args ...]: printing the arguments (-n: without a newline, -e: with backslash escapes, just like /bin/echo)
+int builtin_echo(char *const *argv);
+
+// true/false: doing nothing, successfully or not
+int builtin_true(char *const *argv);
+int builtin_false(char *const *argv);
+
+// test expr / [ expr ]: evaluating a POSIX test expression (of up to 4 arguments), returning 0 if it is true, 1 if it is false
+// and 2 if it can't be understood
+int builtin_test(char *const *argv);
+
+// printf format [args ...]: printing the arguments through the format, which is reused for as long as arguments are left
+int builtin_printf(char *const *argv);
+
+// cat [files ...]: copying each file (or stdin, for none or -) to stdout, inside the kernel whenever it can (see copy.h)
+// there are no options, so the shell only runs it in place of a cat without any (see findStageBuiltin)
+int builtin_cat(char *const *argv);
+
+// tee [-a] [files ...]: copying stdin to stdout and to each of the files (appending to them with -a)
+int builtin_tee(char *const *argv);
+
+// pwd: printing the current working directory
+int builtin_pwd(char *const *argv);
+
+#endif /* _BUILTINS_H */
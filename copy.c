@@ -0,0 +1,232 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#define _GNU_SOURCE // for copy_file_range, splice and tee
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+
+// ************** Including the necessary header file **************
+
+#include "copy.h"
+
+// ************** Define macros **************
+
+#define COPY_CHUNK (1 << 30) // the most a single copy_file_range, sendfile or splice is asked to move
+#define BUFFER_SIZE (1 << 16) // the buffer read and write go through
+
+// ************** Define types **************
+
+// the ways of copying, from the fastest to the one which always works
+typedef enum copy_method
+{
+  COPY_FILE_RANGE, // file to file, possibly without even touching the data (a reflink, or a copy done by the device)
+  COPY_SENDFILE,   // file to anything
+  COPY_SPLICE,     // from or into a pipe
+  COPY_READ_WRITE,
+} copy_method_t;
+
+// ************** Declaring helper functions **************
+
+static copy_method_t pick_method(int in, int out);
+static int write_all(int fd, const char *buffer, size_t size);
+static long long copy_buffered(int in, int out, const int *files, int num_files);
+
+// ************** Defining the functions **************
+
+// picking the fastest way of copying which the kinds of the descriptors allow
+
+static copy_method_t pick_method(int in, int out)
+{
+  struct stat in_info, out_info;
+  if (fstat(in, &in_info) == -1 || fstat(out, &out_info) == -1)
+  {
+    return COPY_READ_WRITE;
+  }
+  if (S_ISFIFO(in_info.st_mode) || S_ISFIFO(out_info.st_mode))
+  {
+    return COPY_SPLICE;
+  }
+  if (S_ISREG(in_info.st_mode))
+  {
+    return S_ISREG(out_info.st_mode) ? COPY_FILE_RANGE : COPY_SENDFILE;
+  }
+  return COPY_READ_WRITE;
+}
+
+// writing the whole buffer, however many write calls it takes
+// returns 0, or -1 if writing failed
+
+static int write_all(int fd, const char *buffer, size_t size)
+{
+  while (size > 0)
+  {
+    ssize_t written = write(fd, buffer, size);
+    if (written == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (written == -1)
+    {
+      return -1;
+    }
+    buffer += written;
+    size -= written;
+  }
+  return 0;
+}
+
+// copying everything from in to out and to each of the files through a buffer
+
+static long long copy_buffered(int in, int out, const int *files, int num_files)
+{
+  char *buffer = malloc(BUFFER_SIZE);
+  if (buffer == NULL)
+  {
+    return -1;
+  }
+
+  long long total = 0;
+  while (1)
+  {
+    ssize_t got = read(in, buffer, BUFFER_SIZE);
+    if (got == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (got <= 0)
+    {
+      total = (got == 0) ? total : -1;
+      break;
+    }
+
+    int failed = (write_all(out, buffer, got) == -1);
+    for (int index = 0; index < num_files && !failed; ++index)
+    {
+      failed = (write_all(files[index], buffer, got) == -1);
+    }
+    if (failed)
+    {
+      total = -1;
+      break;
+    }
+    total += got;
+  }
+
+  free(buffer);
+  return total;
+}
+
+// copying everything from in to out, inside the kernel whenever it can
+
+long long copy_fd(int in, int out)
+{
+  copy_method_t method = pick_method(in, out);
+  long long total = 0;
+
+  while (method != COPY_READ_WRITE)
+  {
+    ssize_t copied;
+    if (method == COPY_FILE_RANGE)
+    {
+      copied = copy_file_range(in, NULL, out, NULL, COPY_CHUNK, 0);
+    }
+    else if (method == COPY_SENDFILE)
+    {
+      copied = sendfile(out, in, NULL, COPY_CHUNK);
+    }
+    else
+    {
+      copied = splice(in, NULL, out, NULL, COPY_CHUNK, SPLICE_F_MOVE);
+    }
+
+    if (copied == 0)
+    {
+      return total;
+    }
+    if (copied > 0)
+    {
+      total += copied;
+      continue;
+    }
+    if (errno == EINTR)
+    {
+      continue;
+    }
+
+    // the kernel (or the file system) can't copy between these two, so the next way is tried; as every one of them moves
+    // the offsets of both descriptors along, it carries on from where the last one stopped
+    if (errno != EINVAL && errno != EXDEV && errno != ENOSYS && errno != EOPNOTSUPP && errno != EBADF)
+    {
+      return -1;
+    }
+    method = (method == COPY_FILE_RANGE) ? COPY_SENDFILE : COPY_READ_WRITE;
+  }
+
+  long long rest = copy_buffered(in, out, NULL, 0);
+  return (rest == -1) ? -1 : total + rest;
+}
+
+// copying everything from in to out and to each of the files at once
+
+long long tee_fd(int in, int out, const int *files, int num_files)
+{
+  if (num_files == 0)
+  {
+    return copy_fd(in, out);
+  }
+
+  long long total = 0;
+  // (the file has to be a regular one, and splice can't write into it if it is opened for appending)
+  if (num_files == 1 && pick_method(in, in) == COPY_SPLICE && pick_method(out, out) == COPY_SPLICE &&
+      pick_method(files[0], files[0]) == COPY_FILE_RANGE && !(fcntl(files[0], F_GETFL) & O_APPEND))
+  {
+    while (1)
+    {
+      // the data is duplicated into out without being taken out of in ...
+      ssize_t duplicated = tee(in, out, COPY_CHUNK, 0);
+      if (duplicated == -1 && errno == EINTR)
+      {
+        continue;
+      }
+      if (duplicated == 0)
+      {
+        return total;
+      }
+      if (duplicated == -1)
+      {
+        if (total == 0 && errno == EINVAL)
+        {
+          break; // nothing has been taken out of in yet, so the buffer can still take over
+        }
+        return -1;
+      }
+
+      // ... and then moved into the file, which takes it out of in
+      for (ssize_t left = duplicated; left > 0;)
+      {
+        ssize_t moved = splice(in, NULL, files[0], NULL, left, SPLICE_F_MOVE);
+        if (moved == -1 && errno == EINTR)
+        {
+          continue;
+        }
+        if (moved <= 0)
+        {
+          return -1;
+        }
+        left -= moved;
+      }
+      total += duplicated;
+    }
+  }
+
+  return copy_buffered(in, out, files, num_files);
+}
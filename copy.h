@@ -0,0 +1,20 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _COPY_H
+#define _COPY_H
+
+// copying everything from in to out (until EOF on in), inside the kernel whenever the descriptors allow it: copy_file_range
+// between two regular files, splice when either of them is a pipe and sendfile from a regular file to anything else, with read
+// and write for the rest (or when the kernel turns one of those down)
+// returns the number of bytes copied, or -1 (with errno set) if reading or writing failed
+long long copy_fd(int in, int out);
+
+// copying everything from in to out and to each of the num_files files at once
+// when in and out are pipes and there is a single file, the data is duplicated into out with tee and moved into the file with
+// splice, so it never leaves the kernel; otherwise it goes through a buffer
+// returns the number of bytes copied, or -1 (with errno set) if reading or writing failed
+long long tee_fd(int in, int out, const int *files, int num_files);
+
+#endif /* _COPY_H */
@@ -0,0 +1,497 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#define _GNU_SOURCE // for memfd_create and mremap
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+// ************** Including the necessary header file **************
+
+#include "history.h"
+
+// ************** Define macros **************
+
+#define HISTORY_RING 64    // how many parsed entries are kept around for being replayed
+#define HISTORY_MERGE 1024 // how many entries may be added before they are merged into the index
+
+// ************** Define types **************
+
+// a parsed entry of the ring
+struct ring_slot
+{
+  size_t number;    // the number of the entry (0 for an empty slot)
+  script_t *script; // its parsed form
+};
+
+// an entry along with the characters it is being sorted by
+struct keyed_entry
+{
+  uint64_t key;
+  uint32_t entry;
+};
+
+// ************** Define global variables **************
+
+static int history_fd = -1;     // the history file (or a memfd standing in for it)
+static const char *mapping;     // the file mapped into memory (NULL until it is first looked at)
+static size_t mapped;           // how much of the file is mapped
+static size_t scanned;          // how much of the file has been split into entries (up to the end of its last complete line)
+
+static size_t *starts;          // where each entry starts in the file, followed by scanned (so entry n runs up to starts[n])
+static size_t num_entries;
+static size_t starts_capacity;
+
+static uint32_t *order;         // the first indexed entries (their index from 0), sorted by their text
+static size_t indexed;
+static uint32_t *latest;        // a segment tree over order: the leaves hold the numbers of the entries, and every other node
+                                // the highest number below it
+
+static struct ring_slot ring[HISTORY_RING]; // entry n is kept in slot n % HISTORY_RING
+
+// ************** Declaring helper functions **************
+
+static void forget_entries();
+static void sync_history();
+static int compare_entries(const void *first, const void *second);
+static uint64_t chunk_at(uint32_t entry, size_t depth);
+static void sort_keys(struct keyed_entry *keyed, size_t count);
+static void sort_entries(uint32_t *entries, size_t count, size_t depth);
+static int compare_prefix(uint32_t entry, const char *prefix, size_t len, int whole);
+static void update_index();
+static size_t range_latest(size_t low, size_t high);
+
+// ************** Defining the functions **************
+
+// opening the history file at path, or keeping the history in memory only
+
+int history_open(const char *path)
+{
+  history_close();
+
+  if (path != NULL)
+  {
+    history_fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+  }
+  if (history_fd == -1)
+  {
+    history_fd = memfd_create("history", MFD_CLOEXEC);
+    return (path != NULL) ? -1 : 0;
+  }
+  return 0;
+}
+
+// adding a line to the history: the line and its newline go out in a single write, so the lines of shells sharing the file
+// never get mixed up
+
+void history_add(const char *line, size_t len)
+{
+  if (history_fd == -1)
+  {
+    return;
+  }
+
+  struct iovec parts[2] = {{(void *)line, len}, {"\n", 1}};
+  while (writev(history_fd, parts, 2) == -1 && errno == EINTR)
+  {
+  }
+}
+
+// forgetting every entry (and the mapping), for when the file has been cut short by someone else
+
+static void forget_entries()
+{
+  if (mapping != NULL)
+  {
+    munmap((void *)mapping, mapped);
+  }
+  mapping = NULL;
+  mapped = 0;
+  scanned = 0;
+  num_entries = 0;
+  indexed = 0;
+
+  for (int index = 0; index < HISTORY_RING; ++index)
+  {
+    if (ring[index].script != NULL)
+    {
+      script_release(ring[index].script);
+    }
+    ring[index].number = 0;
+    ring[index].script = NULL;
+  }
+}
+
+// bringing the entries up to date with the file: mapping what has been added to it since, and finding the new lines in there
+
+static void sync_history()
+{
+  struct stat info;
+  if (history_fd == -1 || fstat(history_fd, &info) == -1)
+  {
+    return;
+  }
+
+  size_t size = info.st_size;
+  if (size < scanned)
+  {
+    forget_entries();
+  }
+  if (size > mapped)
+  {
+    void *grown = (mapping == NULL) ? mmap(NULL, size, PROT_READ, MAP_SHARED, history_fd, 0)
+                                    : mremap((void *)mapping, mapped, size, MREMAP_MAYMOVE);
+    if (grown == MAP_FAILED)
+    {
+      return;
+    }
+    mapping = grown;
+    mapped = size;
+  }
+
+  while (scanned < mapped)
+  {
+    // a line without its newline is still being written (by another shell), and is left for later
+    const char *newline = memchr(&mapping[scanned], '\n', mapped - scanned);
+    if (newline == NULL)
+    {
+      break;
+    }
+
+    if (num_entries + 2 > starts_capacity)
+    {
+      starts_capacity = starts_capacity ? starts_capacity * 2 : 1024;
+      starts = realloc(starts, sizeof(size_t) * starts_capacity);
+      assert(starts != NULL);
+    }
+    starts[num_entries++] = scanned;
+    scanned = newline - mapping + 1;
+    starts[num_entries] = scanned;
+  }
+}
+
+// getting how many entries the history has
+
+size_t history_count()
+{
+  sync_history();
+  return num_entries;
+}
+
+// getting the text of the entry with the given number
+
+const char *history_get(size_t number, size_t *len)
+{
+  sync_history();
+  if (number == 0 || number > num_entries)
+  {
+    return NULL;
+  }
+  *len = starts[number] - starts[number - 1] - 1;
+  return &mapping[starts[number - 1]];
+}
+
+// ordering two entries (given by their index) by their text, and the older one first when they are the same
+
+static int compare_entries(const void *first, const void *second)
+{
+  uint32_t a = *(const uint32_t *)first, b = *(const uint32_t *)second;
+  size_t a_len = starts[a + 1] - starts[a] - 1, b_len = starts[b + 1] - starts[b] - 1;
+
+  int result = memcmp(&mapping[starts[a]], &mapping[starts[b]], (a_len < b_len) ? a_len : b_len);
+  if (result != 0)
+  {
+    return result;
+  }
+  if (a_len != b_len)
+  {
+    return (a_len > b_len) ? 1 : -1;
+  }
+  return (a > b) - (a < b);
+}
+
+// getting the 8 characters of an entry from depth on as a number which orders the same way they do (0 past its end)
+
+static uint64_t chunk_at(uint32_t entry, size_t depth)
+{
+  size_t len = starts[entry + 1] - starts[entry] - 1;
+  uint64_t chunk = 0;
+  for (size_t index = depth; index < depth + 8; ++index)
+  {
+    chunk = (chunk << 8) | ((index < len) ? (unsigned char)mapping[starts[entry] + index] : 0);
+  }
+  return chunk;
+}
+
+// sorting keyed entries by their key, keeping those with the same key in the order they were in
+// this is a radix sort, a byte of the key at a time from the lowest one (skipping the bytes every key has in common), so it takes
+// a few passes over the entries whatever their number
+
+static void sort_keys(struct keyed_entry *keyed, size_t count)
+{
+  struct keyed_entry *spare = malloc(sizeof(struct keyed_entry) * count);
+  assert(spare != NULL);
+  struct keyed_entry *from = keyed, *to = spare;
+
+  for (int shift = 0; shift < 64; shift += 8)
+  {
+    size_t counts[256] = {0};
+    for (size_t index = 0; index < count; ++index)
+    {
+      counts[(from[index].key >> shift) & 0xff]++;
+    }
+    if (counts[(from[0].key >> shift) & 0xff] == count)
+    {
+      continue;
+    }
+
+    size_t position = 0;
+    for (int byte = 0; byte < 256; ++byte)
+    {
+      size_t next = position + counts[byte];
+      counts[byte] = position;
+      position = next;
+    }
+    for (size_t index = 0; index < count; ++index)
+    {
+      to[counts[(from[index].key >> shift) & 0xff]++] = from[index];
+    }
+    struct keyed_entry *swap = from;
+    from = to;
+    to = swap;
+  }
+
+  if (from != keyed)
+  {
+    memcpy(keyed, from, sizeof(struct keyed_entry) * count);
+  }
+  free(spare);
+}
+
+// sorting entries (given by their index) in the same order as compare_entries, all of which have the same first depth characters
+// they are sorted (from the oldest one, as they are given) by their next 8 characters, taken out of the file once and kept next
+// to the entries (so the sort itself never touches the file), and then every run of them sharing those characters is sorted by the 8 after them, and so on; the beginning
+// a lot of lines share (such as "git commit") is only looked at once per entry, which keeps building the index of a history of
+// millions of lines quick
+
+static void sort_entries(uint32_t *entries, size_t count, size_t depth)
+{
+  struct keyed_entry *keyed = malloc(sizeof(struct keyed_entry) * count);
+  assert(keyed != NULL);
+  for (size_t index = 0; index < count; ++index)
+  {
+    keyed[index].key = chunk_at(entries[index], depth);
+    keyed[index].entry = entries[index];
+  }
+  sort_keys(keyed, count);
+  for (size_t index = 0; index < count; ++index)
+  {
+    entries[index] = keyed[index].entry;
+  }
+
+  for (size_t first = 0, last; first < count; first = last)
+  {
+    // (when every one of them ends within those 8 characters, they are all the same line, ordered from the oldest one)
+    int longer = 0;
+    for (last = first; last < count && keyed[last].key == keyed[first].key; ++last)
+    {
+      longer |= (starts[keyed[last].entry + 1] - starts[keyed[last].entry] - 1 > depth + 8);
+    }
+    if (last - first > 1 && longer)
+    {
+      sort_entries(&entries[first], last - first, depth + 8);
+    }
+  }
+  free(keyed);
+}
+
+// comparing the text of an entry with the prefix: as a whole (whole), or only as far as the prefix goes
+
+static int compare_prefix(uint32_t entry, const char *prefix, size_t len, int whole)
+{
+  size_t entry_len = starts[entry + 1] - starts[entry] - 1;
+  int result = memcmp(&mapping[starts[entry]], prefix, (entry_len < len) ? entry_len : len);
+  if (result != 0 || !whole)
+  {
+    return result;
+  }
+  return (entry_len > len) - (entry_len < len);
+}
+
+// merging the entries added since the index was last brought up to date into it, once there are enough of them
+// they are sorted on their own and merged with the sorted entries in a single pass, after which the tree is built again
+// from its leaves
+
+static void update_index()
+{
+  size_t added = num_entries - indexed;
+  if (added <= HISTORY_MERGE)
+  {
+    return;
+  }
+
+  uint32_t *fresh = malloc(sizeof(uint32_t) * added);
+  uint32_t *merged = malloc(sizeof(uint32_t) * num_entries);
+  assert(fresh != NULL && merged != NULL);
+  for (size_t index = 0; index < added; ++index)
+  {
+    fresh[index] = indexed + index;
+  }
+  sort_entries(fresh, added, 0);
+
+  size_t old = 0, new = 0, count = 0;
+  while (old < indexed || new < added)
+  {
+    if (new == added || (old < indexed && compare_entries(&order[old], &fresh[new]) < 0))
+    {
+      merged[count++] = order[old++];
+    }
+    else
+    {
+      merged[count++] = fresh[new++];
+    }
+  }
+  free(fresh);
+  free(order);
+  order = merged;
+  indexed = num_entries;
+
+  free(latest);
+  latest = malloc(sizeof(uint32_t) * 2 * indexed);
+  assert(latest != NULL);
+  for (size_t index = 0; index < indexed; ++index)
+  {
+    latest[indexed + index] = order[index] + 1;
+  }
+  for (size_t node = indexed - 1; node > 0; --node)
+  {
+    uint32_t left = latest[2 * node], right = latest[2 * node + 1];
+    latest[node] = (left > right) ? left : right;
+  }
+}
+
+// getting the highest number among the entries at positions low to high (excluded) of the index, or 0 if there is none
+
+static size_t range_latest(size_t low, size_t high)
+{
+  uint32_t best = 0;
+  for (low += indexed, high += indexed; low < high; low /= 2, high /= 2)
+  {
+    if (low & 1)
+    {
+      best = (latest[low] > best) ? latest[low] : best;
+      ++low;
+    }
+    if (high & 1)
+    {
+      --high;
+      best = (latest[high] > best) ? latest[high] : best;
+    }
+  }
+  return best;
+}
+
+// finding the most recent entry starting with the prefix
+
+size_t history_find_prefix(const char *prefix, size_t len)
+{
+  sync_history();
+  update_index();
+
+  // the entries which aren't in the index yet are the most recent ones, so they are looked at first
+  for (size_t number = num_entries; number > indexed; --number)
+  {
+    if (starts[number] - starts[number - 1] - 1 >= len && memcmp(&mapping[starts[number - 1]], prefix, len) == 0)
+    {
+      return number;
+    }
+  }
+
+  // the entries starting with the prefix are all next to each other in the index: from the first one which isn't smaller than
+  // the prefix, up to the first one whose beginning is larger than it
+  size_t low = 0, high = indexed;
+  while (low < high)
+  {
+    size_t middle = low + (high - low) / 2;
+    if (compare_prefix(order[middle], prefix, len, 1) < 0)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  size_t first = low;
+  high = indexed;
+  while (low < high)
+  {
+    size_t middle = low + (high - low) / 2;
+    if (compare_prefix(order[middle], prefix, len, 0) <= 0)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  return range_latest(first, low);
+}
+
+// getting the parsed form of the entry with the given number, from the ring if it has been replayed lately
+
+script_t *history_parsed(size_t number)
+{
+  size_t len;
+  const char *text = history_get(number, &len);
+  if (text == NULL)
+  {
+    return NULL;
+  }
+
+  struct ring_slot *slot = &ring[number % HISTORY_RING];
+  if (slot->number != number)
+  {
+    if (slot->script != NULL)
+    {
+      script_release(slot->script);
+    }
+    slot->script = script_parse(text, len);
+    slot->number = number;
+  }
+
+  slot->script->refs++; // one reference for the ring, one for the caller
+  return slot->script;
+}
+
+// giving back everything held by the history
+
+void history_close()
+{
+  forget_entries();
+  free(starts);
+  free(order);
+  free(latest);
+  starts = NULL;
+  order = NULL;
+  latest = NULL;
+  starts_capacity = 0;
+
+  if (history_fd != -1)
+  {
+    close(history_fd);
+  }
+  history_fd = -1;
+}
@@ -0,0 +1,46 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _HISTORY_H
+#define _HISTORY_H
+
+#include <stddef.h>
+
+#include "scriptcache.h"
+
+// the history of the lines entered at the prompt, numbered from 1, kept in an append-only file shared by every shell using it:
+// each line is appended with a single write as soon as it is entered, and the file is mapped into memory (and mapped again as
+// it grows, from this shell or from another one) rather than read. nothing is loaded until the history is first looked at.
+// the number of an entry is its line in the file, so it stays the same across sessions.
+
+// opening the history file at path (created if it doesn't exist), or keeping the history in memory only when path is NULL
+// returns 0, or -1 if the file couldn't be opened (the history is then kept in memory only)
+int history_open(const char *path);
+
+// adding a line of len bytes (without its newline) to the history
+void history_add(const char *line, size_t len);
+
+// getting how many entries the history has (including those added by other shells so far)
+size_t history_count();
+
+// getting the text of the entry with the given number (without its newline), whose length is stored in len
+// returns NULL if there is no such entry; the text is only valid until the history is used again
+const char *history_get(size_t number, size_t *len);
+
+// finding the most recent entry starting with the prefix of len bytes
+// the entries are kept sorted in an index (and the maximum number over every range of it in a segment tree), so the answer is
+// found in logarithmic time however long the history is; only the entries added since the index was last brought up to date
+// (a bounded number of them) are looked at one by one
+// returns the number of the entry, or 0 if there is none
+size_t history_find_prefix(const char *prefix, size_t len);
+
+// getting the parsed form of the entry with the given number, which is kept in a ring of the recently replayed entries, so an
+// entry run again is never tokenized again (entries never change, as the file is only ever appended to)
+// returns NULL if there is no such entry; the script has to be given back with script_release
+script_t *history_parsed(size_t number);
+
+// giving back everything held by the history, and closing its file
+void history_close();
+
+#endif /* _HISTORY_H */
@@ -0,0 +1,331 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// ************** Including the necessary header file **************
+
+#include "jobs.h"
+#include "trace.h"
+
+// ************** Define global variables **************
+
+// the table of jobs, indexed by job number - 1 (NULL for a number which is free)
+// the SIGCHLD handler goes through it, so it is only ever changed with SIGCHLD blocked
+static job_t **jobs = NULL;
+static int jobs_capacity = 0;
+
+static sigset_t sigchld_set; // just SIGCHLD, for blocking it
+
+// ************** Declaring helper functions **************
+
+static void reap_jobs();
+static void on_sigchld(int sig);
+static void forget_job(job_t *job);
+static void print_jobs(int finished_only);
+static const char *job_state(const job_t *job, char *buffer, size_t size);
+
+// ************** Defining the functions **************
+
+// reaping every process of every job which has finished (or been stopped/continued), without blocking
+// this runs inside the signal handler, so it can do nothing but call waitpid and update the jobs
+
+static void reap_jobs()
+{
+  for (int index = 0; index < jobs_capacity; ++index)
+  {
+    job_t *job = jobs[index];
+    if (job == NULL)
+    {
+      continue;
+    }
+
+    for (int proc = 0; proc < job->num_procs; ++proc)
+    {
+      int status;
+      if (job->pids[proc] == -1 || waitpid(job->pids[proc], &status, WNOHANG | WUNTRACED | WCONTINUED) <= 0)
+      {
+        continue;
+      }
+
+      if (WIFSTOPPED(status))
+      {
+        job->stopped = 1;
+      }
+      else if (WIFCONTINUED(status))
+      {
+        job->stopped = 0;
+      }
+      else
+      {
+        trace_event(TRACE_CHILD_EXIT, NULL, job->pids[proc], status);
+        job->statuses[proc] = status;
+        job->pids[proc] = -1;
+        job->num_running--;
+      }
+    }
+  }
+}
+
+// the SIGCHLD handler, reaping the processes of every job as soon as they finish, so that they never linger as zombies
+// (the processes of a command running in the foreground aren't part of any job, and are left for the shell to wait for)
+
+static void on_sigchld(int sig)
+{
+  (void)sig;
+  int saved_errno = errno;
+  reap_jobs();
+  errno = saved_errno;
+}
+
+// installing the SIGCHLD handler
+
+void jobs_init()
+{
+  sigemptyset(&sigchld_set);
+  sigaddset(&sigchld_set, SIGCHLD);
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = on_sigchld;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART; // reading the next command (or waiting for one in the foreground) just carries on
+  sigaction(SIGCHLD, &action, NULL);
+}
+
+// adding a job for the stages launched in the background
+
+job_t *job_add(const pid_t *pids, const int *statuses, int num, const char *command)
+{
+  job_t *job = malloc(sizeof(job_t));
+  assert(job != NULL);
+
+  job->pids = malloc(sizeof(pid_t) * num);
+  job->statuses = malloc(sizeof(int) * num);
+  job->command = strdup(command);
+  assert(job->pids != NULL && job->statuses != NULL && job->command != NULL);
+
+  memcpy(job->pids, pids, sizeof(pid_t) * num);
+  memcpy(job->statuses, statuses, sizeof(int) * num);
+  job->num_procs = num;
+  job->num_running = 0;
+  job->stopped = 0;
+  job->pgid = -1;
+
+  pid_t last_pid = -1;
+  for (int proc = 0; proc < num; ++proc)
+  {
+    if (pids[proc] != -1)
+    {
+      job->num_running++;
+      last_pid = pids[proc];
+      if (job->pgid == -1)
+      {
+        job->pgid = pids[proc];
+      }
+    }
+  }
+
+  sigset_t old_mask;
+  sigprocmask(SIG_BLOCK, &sigchld_set, &old_mask);
+
+  // taking the lowest free number, just like other shells do
+  int index = 0;
+  while (index < jobs_capacity && jobs[index] != NULL)
+  {
+    index++;
+  }
+  if (index == jobs_capacity)
+  {
+    jobs_capacity = jobs_capacity ? jobs_capacity * 2 : 16;
+    jobs = realloc(jobs, sizeof(job_t *) * jobs_capacity);
+    assert(jobs != NULL);
+    memset(&jobs[index], 0, sizeof(job_t *) * (jobs_capacity - index));
+  }
+  job->id = index + 1;
+  jobs[index] = job;
+
+  // a stage may have finished before it was in the table, in which case its SIGCHLD has already come and gone
+  reap_jobs();
+  sigprocmask(SIG_SETMASK, &old_mask, NULL);
+
+  printf("[%d] %d\n", job->id, (int)last_pid);
+  fflush(stdout); // before the job gets a chance to print anything
+  return job;
+}
+
+// finding a job by its number, or the most recent one for 0
+
+job_t *job_find(int id)
+{
+  if (id == 0)
+  {
+    for (int index = jobs_capacity - 1; index >= 0; --index)
+    {
+      if (jobs[index] != NULL)
+      {
+        return jobs[index];
+      }
+    }
+    return NULL;
+  }
+
+  if (id < 0 || id > jobs_capacity)
+  {
+    return NULL;
+  }
+  return jobs[id - 1];
+}
+
+// freeing a job and its number
+
+static void forget_job(job_t *job)
+{
+  sigset_t old_mask;
+  sigprocmask(SIG_BLOCK, &sigchld_set, &old_mask);
+  jobs[job->id - 1] = NULL;
+  sigprocmask(SIG_SETMASK, &old_mask, NULL);
+
+  free(job->pids);
+  free(job->statuses);
+  free(job->command);
+  free(job);
+}
+
+// waiting for every stage of a job to finish (or for it to be stopped)
+// SIGCHLD stays blocked except while sigsuspend sleeps, so the job can't finish between looking at it and going to sleep
+
+int job_wait(job_t *job, int stop)
+{
+  sigset_t old_mask;
+  sigprocmask(SIG_BLOCK, &sigchld_set, &old_mask);
+
+  while (job->num_running > 0 && !(stop && job->stopped))
+  {
+    sigsuspend(&old_mask);
+  }
+
+  sigprocmask(SIG_SETMASK, &old_mask, NULL);
+
+  if (job->num_running > 0)
+  {
+    printf("[%d] Stopped    %s\n", job->id, job->command);
+    return -1;
+  }
+
+  int status = job->statuses[job->num_procs - 1];
+  forget_job(job);
+  return status;
+}
+
+// continuing a stopped job in the foreground or in the background
+
+void job_continue(job_t *job, int foreground)
+{
+  // the terminal (if there is one, and it is ours) goes to the job, so that it can read from it and gets the CTRL + C/Z
+  int terminal = foreground && isatty(0) && tcgetpgrp(0) == getpgrp();
+  if (terminal)
+  {
+    tcsetpgrp(0, job->pgid);
+  }
+
+  sigset_t old_mask;
+  sigprocmask(SIG_BLOCK, &sigchld_set, &old_mask);
+  job->stopped = 0;
+  sigprocmask(SIG_SETMASK, &old_mask, NULL);
+
+  if (job->pgid > 0)
+  {
+    kill(-job->pgid, SIGCONT);
+  }
+
+  if (!foreground)
+  {
+    printf("[%d] %s &\n", job->id, job->command);
+    return;
+  }
+
+  printf("%s\n", job->command);
+  job_wait(job, 1);
+
+  // taking the terminal back, which a process outside of the foreground group may only do with SIGTTOU blocked
+  if (terminal)
+  {
+    sigset_t ttou_set;
+    sigemptyset(&ttou_set);
+    sigaddset(&ttou_set, SIGTTOU);
+    sigprocmask(SIG_BLOCK, &ttou_set, &old_mask);
+    tcsetpgrp(0, getpgrp());
+    sigprocmask(SIG_SETMASK, &old_mask, NULL);
+  }
+}
+
+// describing the state of a job for listing it
+
+static const char *job_state(const job_t *job, char *buffer, size_t size)
+{
+  if (job->num_running > 0)
+  {
+    return job->stopped ? "Stopped" : "Running";
+  }
+
+  int status = job->statuses[job->num_procs - 1];
+  if (WIFSIGNALED(status))
+  {
+    return strsignal(WTERMSIG(status));
+  }
+  if (WEXITSTATUS(status) != 0)
+  {
+    snprintf(buffer, size, "Exit %d", WEXITSTATUS(status));
+    return buffer;
+  }
+  return "Done";
+}
+
+// printing every job, or just the ones which have finished, and forgetting the finished ones
+
+static void print_jobs(int finished_only)
+{
+  char buffer[32];
+
+  for (int index = 0; index < jobs_capacity; ++index)
+  {
+    job_t *job = jobs[index];
+    if (job == NULL || (finished_only && job->num_running > 0))
+    {
+      continue;
+    }
+
+    printf("[%d] %-10s %s\n", job->id, job_state(job, buffer, sizeof(buffer)), job->command);
+    if (job->num_running == 0)
+    {
+      forget_job(job);
+    }
+  }
+}
+
+// printing every job along with its state
+
+void jobs_print()
+{
+  print_jobs(0);
+}
+
+// printing the jobs which have finished since this was last called
+
+void jobs_notify()
+{
+  print_jobs(1);
+}
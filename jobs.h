@@ -0,0 +1,48 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _JOBS_H
+#define _JOBS_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// a command running in the background, made of one process per stage of its pipeline
+// the processes are reaped by the SIGCHLD handler as soon as they finish, which fills in their statuses
+typedef struct job
+{
+  int id;          // the number the job is referred to by (%1, %2, ...)
+  pid_t pgid;      // the process group every stage was put in
+  pid_t *pids;     // the pid of each stage (-1 for a stage which couldn't be started)
+  int *statuses;   // the wait status of each stage, once it has finished
+  int num_procs;
+  int num_running; // how many stages haven't finished yet
+  int stopped;     // whether the job was stopped (by a signal) and is waiting to be continued
+  char *command;   // the command the job is running, for listing it
+} job_t;
+
+// installing the SIGCHLD handler which reaps the processes of every job
+void jobs_init();
+
+// adding a job for the num stages launched in the background (with their pids and, for the ones which couldn't be started,
+// their statuses), and printing its number and pid
+job_t *job_add(const pid_t *pids, const int *statuses, int num, const char *command);
+
+// finding a job by its number, or the most recent one for 0; returns NULL if there is no such job
+job_t *job_find(int id);
+
+// waiting for every stage of a job to finish (or, if stop is set, for the job to be stopped), and forgetting it if it finished
+// returns the wait status of its last stage
+int job_wait(job_t *job, int stop);
+
+// continuing a stopped job, either in the foreground (waiting for it, with the terminal handed over to it) or in the background
+void job_continue(job_t *job, int foreground);
+
+// printing every job along with its state, and forgetting the ones which have finished
+void jobs_print();
+
+// printing (and forgetting) the jobs which have finished since this was last called
+void jobs_notify();
+
+#endif /* _JOBS_H */
@@ -0,0 +1,530 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#define _GNU_SOURCE // for ppoll and pipe2
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// ************** Including the necessary header files **************
+
+#include "parallel.h"
+#include "spawn.h"
+
+// ************** Define macros **************
+
+#define MAX_FAILURES 101 // the exit status is the number of failed runs, up to this many (just like GNU parallel)
+
+// ************** Define types **************
+
+// a single run of the command, for one of the inputs
+typedef struct task
+{
+  pid_t pid;       // the pid of the run (-1 once it has been reaped, or if it couldn't be started)
+  int out_fd;      // the read end of the pipe its stdout goes into (-1 once it has reached EOF)
+  int status;      // its wait status, once it has been reaped
+  int finished;    // whether it has been reaped and its output read in full
+  int killed;      // whether it was stopped because another run failed (its output is then thrown away)
+  char *output;    // everything it has written so far
+  size_t output_len;
+  size_t output_capacity;
+} task_t;
+
+// everything making up a call to parallel
+typedef struct parallel
+{
+  long max_running;      // how many runs may be going at once
+  int keep_order;        // whether the outputs are printed in the order of the inputs
+  int fail_fast;         // whether the first failure stops every other run
+  char *const *command;  // the command to run, and its arguments
+  int command_len;
+  int has_placeholder;   // whether any of them contains {}
+  char **inputs;         // one input per run
+  int num_inputs;
+  int owns_inputs;       // whether the inputs were read from stdin (and have to be freed)
+} parallel_t;
+
+// ************** Declaring helper functions **************
+
+static int parse_args(char *const *argv, parallel_t *config);
+static void read_inputs(parallel_t *config);
+static char *substitute(const char *word, const char *input);
+static pid_t launch_task(const parallel_t *config, int index, task_t *task, int null_fd);
+static void write_all(const char *data, size_t len);
+static void read_output(task_t *task);
+static void on_sigchld(int sig);
+
+// ************** Defining the functions **************
+
+// splitting the arguments of the builtin into its options, the command and the inputs
+// returns -1 (after saying so) if they don't make sense
+
+static int parse_args(char *const *argv, parallel_t *config)
+{
+  memset(config, 0, sizeof(parallel_t));
+  config->max_running = sysconf(_SC_NPROCESSORS_ONLN);
+  if (config->max_running < 1)
+  {
+    config->max_running = 1;
+  }
+
+  int index = 1;
+  for (; argv[index] != NULL && argv[index][0] == '-'; ++index)
+  {
+    if (strcmp(argv[index], "-k") == 0)
+    {
+      config->keep_order = 1;
+    }
+    else if (strcmp(argv[index], "--fail-fast") == 0)
+    {
+      config->fail_fast = 1;
+    }
+    else if (strncmp(argv[index], "-j", 2) == 0)
+    {
+      const char *count = argv[index][2] != '\0' ? &argv[index][2] : argv[++index];
+      char *end;
+      config->max_running = (count != NULL) ? strtol(count, &end, 10) : 0;
+      if (count == NULL || *end != '\0' || config->max_running < 1)
+      {
+        printf("parallel: -j needs a number of jobs above 0\n");
+        return -1;
+      }
+    }
+    else
+    {
+      printf("parallel: unknown option '%s'\n", argv[index]);
+      return -1;
+    }
+  }
+
+  config->command = &argv[index];
+  while (argv[index] != NULL && strcmp(argv[index], ":::") != 0)
+  {
+    if (strstr(argv[index], "{}") != NULL)
+    {
+      config->has_placeholder = 1;
+    }
+    config->command_len++;
+    index++;
+  }
+
+  if (config->command_len == 0)
+  {
+    printf("usage: parallel [-j N] [-k] [--fail-fast] command [args ...] [::: inputs ...]\n");
+    return -1;
+  }
+
+  if (argv[index] != NULL)
+  {
+    config->inputs = (char **)&argv[index + 1];
+    while (config->inputs[config->num_inputs] != NULL)
+    {
+      config->num_inputs++;
+    }
+  }
+  else
+  {
+    read_inputs(config);
+  }
+  return 0;
+}
+
+// reading one input per line from stdin, until its end
+// the descriptor is read directly, as the stdio buffer of stdin may still hold lines meant for the shell itself
+
+static void read_inputs(parallel_t *config)
+{
+  char *data = NULL;
+  size_t len = 0;
+  size_t capacity = 0;
+
+  while (1)
+  {
+    if (len == capacity)
+    {
+      capacity = capacity ? capacity * 2 : 4096;
+      data = realloc(data, capacity);
+      assert(data != NULL);
+    }
+
+    ssize_t bytes = read(0, &data[len], capacity - len);
+    if (bytes == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (bytes <= 0)
+    {
+      break;
+    }
+    len += bytes;
+  }
+
+  int capacity_inputs = 0;
+  size_t start = 0;
+  while (start < len)
+  {
+    char *newline = memchr(&data[start], '\n', len - start);
+    size_t line_len = (newline != NULL) ? (size_t)(newline - &data[start]) : len - start;
+
+    if (line_len > 0)
+    {
+      if (config->num_inputs == capacity_inputs)
+      {
+        capacity_inputs = capacity_inputs ? capacity_inputs * 2 : 64;
+        config->inputs = realloc(config->inputs, sizeof(char *) * capacity_inputs);
+        assert(config->inputs != NULL);
+      }
+      config->inputs[config->num_inputs++] = strndup(&data[start], line_len);
+    }
+    start += line_len + 1;
+  }
+
+  free(data);
+  config->owns_inputs = 1;
+}
+
+// replacing every {} in a word of the command with the input
+
+static char *substitute(const char *word, const char *input)
+{
+  size_t word_len = strlen(word);
+  size_t input_len = strlen(input);
+  size_t count = 0;
+
+  for (const char *found = strstr(word, "{}"); found != NULL; found = strstr(found + 2, "{}"))
+  {
+    count++;
+  }
+
+  char *result = malloc(word_len + count * input_len + 1);
+  assert(result != NULL);
+
+  char *out = result;
+  const char *from = word;
+  for (const char *found = strstr(from, "{}"); found != NULL; found = strstr(from, "{}"))
+  {
+    memcpy(out, from, found - from);
+    out += found - from;
+    memcpy(out, input, input_len);
+    out += input_len;
+    from = found + 2;
+  }
+  strcpy(out, from);
+  return result;
+}
+
+// launching the run for the input at index, with its stdout going into a pipe of its own and its stdin coming from /dev/null
+
+static pid_t launch_task(const parallel_t *config, int index, task_t *task, int null_fd)
+{
+  const char *input = config->inputs[index];
+  char **argv = malloc(sizeof(char *) * (config->command_len + 2));
+  assert(argv != NULL);
+
+  int argc = 0;
+  for (; argc < config->command_len; ++argc)
+  {
+    argv[argc] = config->has_placeholder ? substitute(config->command[argc], input) : config->command[argc];
+  }
+  if (!config->has_placeholder)
+  {
+    argv[argc++] = (char *)input;
+  }
+  argv[argc] = NULL;
+
+  int pipe_fds[2];
+  task->out_fd = -1;
+  task->pid = -1;
+
+  if (pipe2(pipe_fds, O_CLOEXEC) == 0)
+  {
+    spawn_request_t request = {
+        .argv = argv,
+        .in_fd = (null_fd != -1) ? null_fd : 0,
+        .out_fd = pipe_fds[1],
+        .close_fd = pipe_fds[0],
+    };
+
+    task->pid = spawn_process(&request);
+    close(pipe_fds[1]);
+
+    if (task->pid != -1)
+    {
+      task->out_fd = pipe_fds[0];
+    }
+    else
+    {
+      close(pipe_fds[0]);
+      printf("parallel: %s: command not found\n", argv[0]);
+      fflush(stdout);
+    }
+  }
+
+  if (config->has_placeholder)
+  {
+    for (int word = 0; word < config->command_len; ++word)
+    {
+      free(argv[word]);
+    }
+  }
+  free(argv);
+
+  if (task->pid == -1)
+  {
+    task->status = W_EXITCODE(127, 0);
+  }
+  return task->pid;
+}
+
+// writing everything to stdout, however many calls to write that takes
+
+static void write_all(const char *data, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t bytes = write(1, data, len);
+    if (bytes == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (bytes <= 0)
+    {
+      return;
+    }
+    data += bytes;
+    len -= bytes;
+  }
+}
+
+// taking in whatever a run has written, closing the pipe once it reaches EOF
+
+static void read_output(task_t *task)
+{
+  if (task->output_capacity - task->output_len < 4096)
+  {
+    task->output_capacity = task->output_capacity ? task->output_capacity * 2 : 8192;
+    task->output = realloc(task->output, task->output_capacity);
+    assert(task->output != NULL);
+  }
+
+  ssize_t bytes = read(task->out_fd, &task->output[task->output_len], task->output_capacity - task->output_len);
+  if (bytes > 0)
+  {
+    task->output_len += bytes;
+  }
+  else if (bytes == 0 || errno != EINTR)
+  {
+    close(task->out_fd);
+    task->out_fd = -1;
+  }
+}
+
+// a SIGCHLD handler which does nothing but wake up ppoll, for when nothing else is catching the signal
+
+static void on_sigchld(int sig)
+{
+  (void)sig;
+}
+
+/*
+ * Running the command for every input, with up to max_running runs going at once.
+ *
+ * SIGCHLD is kept blocked, except while waiting in ppoll, so that a run finishing at any point wakes the loop up rather than
+ * slipping in before it goes to sleep. Every time the loop wakes up, it reads what the runs have written, reaps the ones which have
+ * exited (without blocking, and only the pids it launched, so that the shell's background jobs are left alone), prints the output of
+ * the runs which are over, and launches new runs in place of the finished ones.
+ */
+int parallel_main(char *const *argv)
+{
+  parallel_t config;
+  if (parse_args(argv, &config) == -1)
+  {
+    return 255;
+  }
+
+  // there is never a pipe to watch for more than the runs going at once
+  size_t num_slots = (config.max_running < config.num_inputs ? config.max_running : config.num_inputs) + 1;
+  task_t *tasks = calloc(config.num_inputs + 1, sizeof(task_t));
+  struct pollfd *fds = malloc(sizeof(struct pollfd) * num_slots);
+  int *fd_tasks = malloc(sizeof(int) * num_slots); // the run each pipe in fds belongs to
+  assert(tasks != NULL && fds != NULL && fd_tasks != NULL);
+
+  int null_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+  // ppoll can only be woken up by SIGCHLD if something catches it
+  struct sigaction old_action;
+  sigaction(SIGCHLD, NULL, &old_action);
+  int own_handler = (old_action.sa_handler == SIG_DFL || old_action.sa_handler == SIG_IGN);
+  if (own_handler)
+  {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_sigchld;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGCHLD, &action, NULL);
+  }
+
+  sigset_t sigchld_set;
+  sigset_t old_mask;
+  sigemptyset(&sigchld_set);
+  sigaddset(&sigchld_set, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &sigchld_set, &old_mask);
+
+  fflush(stdout);
+
+  int next_launch = 0; // the next input to launch a run for
+  int next_print = 0;  // the next run to print the output of, with -k
+  int running = 0;     // runs launched which aren't over yet
+  int failures = 0;
+  int halted = 0;      // whether a failure stopped everything (with --fail-fast)
+
+  while (1)
+  {
+    // launching as many runs as there is room for, with SIGCHLD unblocked so that the children don't start with it blocked
+    if (!halted && running < config.max_running && next_launch < config.num_inputs)
+    {
+      sigprocmask(SIG_SETMASK, &old_mask, NULL);
+      while (running < config.max_running && next_launch < config.num_inputs)
+      {
+        launch_task(&config, next_launch, &tasks[next_launch], null_fd);
+        next_launch++;
+        running++;
+      }
+      sigprocmask(SIG_BLOCK, &sigchld_set, NULL);
+    }
+
+    // reaping the runs which have exited, and finishing the ones whose output has been read in full as well
+    int num_fds = 0;
+    for (int index = next_print; index < next_launch; ++index)
+    {
+      task_t *task = &tasks[index];
+      if (task->finished)
+      {
+        continue;
+      }
+
+      if (task->pid != -1 && waitpid(task->pid, &task->status, WNOHANG) == task->pid)
+      {
+        task->pid = -1;
+      }
+
+      if (task->out_fd != -1)
+      {
+        fds[num_fds].fd = task->out_fd;
+        fds[num_fds].events = POLLIN;
+        fd_tasks[num_fds++] = index;
+        continue;
+      }
+      if (task->pid != -1)
+      {
+        continue;
+      }
+
+      task->finished = 1;
+      running--;
+
+      if (!task->killed && !(WIFEXITED(task->status) && WEXITSTATUS(task->status) == 0))
+      {
+        failures++;
+
+        // stopping every other run, and launching no more of them
+        if (config.fail_fast && !halted)
+        {
+          halted = 1;
+          for (int other = next_print; other < next_launch; ++other)
+          {
+            if (!tasks[other].finished && tasks[other].pid != -1)
+            {
+              tasks[other].killed = 1;
+              kill(tasks[other].pid, SIGTERM);
+            }
+          }
+        }
+      }
+
+      if (!config.keep_order && !task->killed)
+      {
+        write_all(task->output, task->output_len);
+      }
+    }
+
+    // with -k, the outputs go out in order, as soon as every run before them is over
+    while (next_print < next_launch && tasks[next_print].finished)
+    {
+      task_t *task = &tasks[next_print];
+      if (config.keep_order && !task->killed)
+      {
+        write_all(task->output, task->output_len);
+      }
+      free(task->output);
+      task->output = NULL;
+      next_print++;
+    }
+
+    if (running == 0 && (halted || next_launch == config.num_inputs))
+    {
+      break;
+    }
+    // the runs which are over have left room for new ones
+    if (!halted && running < config.max_running && next_launch < config.num_inputs)
+    {
+      continue;
+    }
+
+    // sleeping until a run writes something or exits
+    if (ppoll(fds, num_fds, NULL, &old_mask) > 0)
+    {
+      for (int index = 0; index < num_fds; ++index)
+      {
+        if (fds[index].revents != 0)
+        {
+          read_output(&tasks[fd_tasks[index]]);
+        }
+      }
+    }
+  }
+
+  sigprocmask(SIG_SETMASK, &old_mask, NULL);
+  if (own_handler)
+  {
+    sigaction(SIGCHLD, &old_action, NULL);
+  }
+
+  if (failures > 0)
+  {
+    printf("parallel: %d of %d jobs failed%s\n", failures, next_launch, halted ? " (stopped after the first failure)" : "");
+  }
+
+  if (null_fd != -1)
+  {
+    close(null_fd);
+  }
+  for (int index = 0; index < config.num_inputs; ++index)
+  {
+    free(tasks[index].output);
+    if (config.owns_inputs)
+    {
+      free(config.inputs[index]);
+    }
+  }
+  if (config.owns_inputs)
+  {
+    free(config.inputs);
+  }
+  free(tasks);
+  free(fds);
+  free(fd_tasks);
+
+  return failures > MAX_FAILURES ? MAX_FAILURES : failures;
+}
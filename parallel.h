@@ -0,0 +1,17 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+// running a command once for each of its inputs, keeping up to N of them running at once:
+//   parallel [-j N] [-k] [--fail-fast] command [args ...] [::: inputs ...]
+// the inputs are read from stdin (one per line) when no ::: is given. every {} in the command is replaced with the input,
+// which is otherwise added as the last argument. the output of each run is collected and printed in one piece, as soon as
+// the run is over (or, with -k, in the order of the inputs). with --fail-fast, the first run to fail stops every other one.
+// N defaults to the number of online CPUs.
+// returns the number of runs which failed (at most 101), or 255 if the command couldn't be understood
+int parallel_main(char *const *argv);
+
+#endif /* _PARALLEL_H */
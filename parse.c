@@ -0,0 +1,311 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// ************** Including the necessary header file **************
+
+#include "parse.h"
+
+// ************** Declaring helper functions **************
+
+static size_t parse_redirect(char *const *tokens, const unsigned char *types, size_t index, size_t num_tokens,
+                             redirect_t *redirects, int *count, const char **error);
+static size_t matching_paren(const unsigned char *types, size_t index, size_t num_tokens);
+static int is_substitution(int type);
+static int is_word(int type);
+
+// ************** Defining the functions **************
+
+// checking whether a token (of the given type) is a substitution $( ... ), quoted or not
+
+static int is_substitution(int type)
+{
+  return TOKEN_TYPE(type) == TOKEN_SUBST || TOKEN_TYPE(type) == TOKEN_SUBST_QUOTED;
+}
+
+// checking whether a token is a word: a plain one, or a substitution which is going to be replaced by words
+
+static int is_word(int type)
+{
+  return TOKEN_TYPE(type) == TOKEN_WORD || is_substitution(type);
+}
+
+// reading the redirection starting at tokens[index]: the descriptor before it (if any), its operators and the word after them
+// >> appends, <> opens the file for reading and writing, >& and <& duplicate a descriptor, and &> (or >& followed by something
+// other than a descriptor) redirects both stdout and stderr into the file
+// returns how many tokens it takes up, with the redirections it stands for (one, or two for &>) in redirects and their number in
+// count, or 0 (with the reason in error) if it is incomplete
+
+static size_t parse_redirect(char *const *tokens, const unsigned char *types, size_t index, size_t num_tokens,
+                             redirect_t *redirects, int *count, const char **error)
+{
+  size_t start = index;
+  int fd = -1;   // the descriptor being redirected (-1 until it is known)
+  int both = 0;  // whether it is for stdout and stderr at once
+
+  // (the tokenizer only gives a descriptor right before a < or >, and the caller only starts at a & right before a >)
+  if (types[index] == TOKEN_REDIR_FD)
+  {
+    fd = tokens[index++][0] - '0';
+  }
+  else if (types[index] == TOKEN_AMP)
+  {
+    both = 1;
+    ++index;
+  }
+
+  int input = (types[index++] == TOKEN_REDIR_IN);
+  redirect_type_t type = input ? REDIRECT_IN : REDIRECT_OUT;
+  if (index < num_tokens && types[index] == TOKEN_REDIR_OUT)
+  {
+    type = input ? REDIRECT_IN_OUT : REDIRECT_APPEND;
+    ++index;
+  }
+  else if (index < num_tokens && types[index] == TOKEN_AMP && !both)
+  {
+    type = REDIRECT_DUP;
+    ++index;
+  }
+
+  if (index >= num_tokens || !is_word(types[index]))
+  {
+    *error = "Error: missing file for redirection.";
+    return 0;
+  }
+  const char *word = tokens[index++];
+
+  if (type == REDIRECT_DUP && !((word[0] >= '0' && word[0] <= '9' && word[1] == '\0') || strcmp(word, "-") == 0))
+  {
+    if (input || fd != -1)
+    {
+      *error = "Error: bad descriptor for redirection.";
+      return 0;
+    }
+    type = REDIRECT_OUT;
+    both = 1;
+  }
+
+  if (fd == -1)
+  {
+    fd = (input) ? 0 : 1;
+  }
+  redirects[0] = (redirect_t){type, fd, word};
+  *count = 1;
+  if (both)
+  {
+    redirects[1] = (redirect_t){REDIRECT_DUP, 2, "1"};
+    *count = 2;
+  }
+  return index - start;
+}
+
+// finding the ) closing the ( at types[index]
+// returns its index, or num_tokens if it is never closed
+
+static size_t matching_paren(const unsigned char *types, size_t index, size_t num_tokens)
+{
+  int depth = 0;
+  for (; index < num_tokens; ++index)
+  {
+    depth += (types[index] == TOKEN_LPAREN) - (types[index] == TOKEN_RPAREN);
+    if (depth == 0)
+    {
+      return index;
+    }
+  }
+  return num_tokens;
+}
+
+// parsing the tokens of a command in a single pass
+// every token is looked at exactly once, by its type alone: the words go into the arguments of the current stage, a redirection
+// takes the word after it as its file (see parse_redirect), a | ends the current stage and a & (or the end of the command) ends the current pipeline.
+// a ( starting a stage makes the tokens up to its matching ) a group, whose commands are parsed by the subshell running them
+// (anywhere else, the parentheses are kept as words). a substitution $( ... ) is kept as a word too, marking its pipeline as one to
+// be expanded right before it runs (see manageShell). the word time at the start of a pipeline is
+// the only one looked at by its characters, as it isn't a program but asks for the pipeline to be timed.
+
+int parse_command(char *const *tokens, const unsigned char *types, command_t *command)
+{
+  size_t num_tokens = 0;
+  while (tokens[num_tokens] != NULL)
+  {
+    ++num_tokens;
+  }
+
+  // every token starts at most one pipeline or stage and is at most one argument (and every stage ends with a NULL), and a
+  // redirection takes at least two tokens for at most two redirections, so the parsed command never needs more room than this,
+  // which is taken in a single allocation
+  size_t max_groups = num_tokens + 1;
+  pipeline_t *pipelines = malloc(sizeof(pipeline_t) * max_groups + sizeof(stage_t) * max_groups +
+                                 sizeof(redirect_t) * num_tokens + sizeof(char *) * (num_tokens + max_groups));
+  assert(pipelines != NULL);
+  stage_t *stages = (stage_t *)(pipelines + max_groups);
+  redirect_t *redirects = (redirect_t *)(stages + max_groups);
+  char **args = (char **)(redirects + num_tokens);
+
+  size_t num_pipelines = 0, num_stages = 0, num_redirects = 0, num_args = 0;
+  pipeline_t *pipeline = NULL; // the pipeline being read (NULL between two of them)
+  stage_t *stage = NULL;       // the stage being read (NULL before the first one of a pipeline and after a |)
+  const char *error = NULL;
+
+  for (size_t index = 0; index <= num_tokens && error == NULL; ++index)
+  {
+    // the end of the command ends the last pipeline, just like a ; does
+    token_type_t type = (index < num_tokens) ? TOKEN_TYPE(types[index]) : TOKEN_SEMI;
+
+    // a & right before a > (&> file) starts a redirection rather than ending the pipeline
+    if (type == TOKEN_AMP && index + 1 < num_tokens && types[index + 1] == TOKEN_REDIR_OUT)
+    {
+      type = TOKEN_REDIR_OUT;
+    }
+
+    switch (type)
+    {
+    case TOKEN_WORD:
+    case TOKEN_SUBST:
+    case TOKEN_SUBST_QUOTED:
+    case TOKEN_LPAREN:
+    case TOKEN_RPAREN:
+    case TOKEN_REDIR_IN:
+    case TOKEN_REDIR_OUT:
+    case TOKEN_REDIR_FD:
+      if (pipeline == NULL)
+      {
+        pipeline = &pipelines[num_pipelines++];
+        pipeline->stages = &stages[num_stages];
+        pipeline->num_stages = 0;
+        pipeline->background = 0;
+        pipeline->timed = 0;
+        pipeline->substitutions = 0;
+        pipeline->tokens = &tokens[index];
+
+        // a pipeline can start with time, as long as something comes after it
+        if (type == TOKEN_WORD && strcmp(tokens[index], "time") == 0 && index + 1 < num_tokens &&
+            types[index + 1] != TOKEN_PIPE && types[index + 1] != TOKEN_AMP && types[index + 1] != TOKEN_SEMI)
+        {
+          pipeline->timed = 1;
+          break;
+        }
+      }
+      if (stage == NULL)
+      {
+        stage = &stages[num_stages++];
+        stage->argv = &args[num_args];
+        stage->redirects = &redirects[num_redirects];
+        stage->num_redirects = 0;
+        stage->group_types = NULL;
+        pipeline->num_stages++;
+
+        if (type == TOKEN_LPAREN)
+        {
+          size_t end = matching_paren(types, index, num_tokens);
+          if (end == num_tokens)
+          {
+            error = "Error: missing ) for (.";
+            break;
+          }
+          if (end == index + 1)
+          {
+            error = "Error: missing command in ( ).";
+            break;
+          }
+          memcpy(&args[num_args], &tokens[index + 1], sizeof(char *) * (end - index - 1));
+          num_args += end - index - 1;
+          stage->group_types = &types[index + 1];
+          index = end; // the group has been taken care of
+          break;
+        }
+      }
+      else if (stage->group_types != NULL &&
+               (is_word(type) || type == TOKEN_LPAREN || type == TOKEN_RPAREN))
+      {
+        error = "Error: unexpected word after ( ).";
+        break;
+      }
+
+      if (is_word(type) || type == TOKEN_LPAREN || type == TOKEN_RPAREN)
+      {
+        args[num_args++] = tokens[index];
+        pipeline->substitutions |= is_substitution(type);
+      }
+      else
+      {
+        int count;
+        size_t used = parse_redirect(tokens, types, index, num_tokens, &redirects[num_redirects], &count, &error);
+        if (used > 0)
+        {
+          pipeline->substitutions |= is_substitution(types[index + used - 1]);
+          num_redirects += count;
+          stage->num_redirects += count;
+          index += used - 1; // the rest of the redirection has been taken care of
+        }
+      }
+      break;
+
+    case TOKEN_PIPE:
+      if (stage == NULL || stage->argv == &args[num_args])
+      {
+        error = "Error: missing command in pipe.";
+        break;
+      }
+      args[num_args++] = NULL;
+      stage = NULL;
+      break;
+
+    case TOKEN_AMP:
+    case TOKEN_SEMI:
+      if (pipeline == NULL)
+      {
+        // nothing at all before a ; (or the end of the command) is fine, but there has to be something to run in the background
+        if (type == TOKEN_AMP)
+        {
+          error = "Error: missing command before &.";
+        }
+        break;
+      }
+      if (stage == NULL || (stage->argv == &args[num_args] && pipeline->num_stages > 1))
+      {
+        error = "Error: missing command in pipe.";
+        break;
+      }
+      if (stage->argv == &args[num_args])
+      {
+        error = "Error: missing command for redirection.";
+        break;
+      }
+      args[num_args++] = NULL;
+      pipeline->background = (type == TOKEN_AMP);
+      pipeline->num_tokens = &tokens[index] - pipeline->tokens;
+      pipeline = NULL;
+      stage = NULL;
+      break;
+    }
+  }
+
+  if (error != NULL)
+  {
+    printf("%s\n", error);
+    free(pipelines);
+    return -1;
+  }
+
+  command->pipelines = pipelines;
+  command->num_pipelines = num_pipelines;
+  return 0;
+}
+
+// freeing the memory held by a parsed command (everything lives in the block starting with its pipelines)
+
+void free_command(command_t *command)
+{
+  free(command->pipelines);
+  command->pipelines = NULL;
+  command->num_pipelines = 0;
+}
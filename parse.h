@@ -0,0 +1,67 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _PARSE_H
+#define _PARSE_H
+
+#include "tokens.h"
+
+// the kinds of redirections
+typedef enum redirect_type
+{
+  REDIRECT_IN,     // n< file (n being 0 unless it is given)
+  REDIRECT_OUT,    // n> file (n being 1 unless it is given), truncating the file
+  REDIRECT_APPEND, // n>> file (1), appending to the file
+  REDIRECT_IN_OUT, // n<> file (0), opened for reading and writing without truncating it
+  REDIRECT_DUP,    // n>&m (1) or n<&m (0): n becomes a copy of the descriptor m, or is closed for n>&-
+} redirect_type_t;
+
+// a redirection of one of the descriptors of a stage
+// &> file and &>> file (and >& file) stand for two of them: stdout into the file, then 2>&1
+typedef struct redirect
+{
+  redirect_type_t type;
+  int fd;           // the descriptor being redirected
+  const char *file; // the file, or (for REDIRECT_DUP) the descriptor it becomes a copy of, or -
+} redirect_t;
+
+// a single program of a pipeline (or a group of commands in parentheses), along with its arguments and redirections
+typedef struct stage
+{
+  char **argv;           // the words of the stage, terminated by NULL (never empty)
+  // for a group ( ... ), run in a subshell of its own: the types of the tokens inside the parentheses, which are what argv holds
+  // (to be parsed as a command of their own by the subshell); NULL for a program
+  const unsigned char *group_types;
+  redirect_t *redirects; // in the order they were given, which is the order they are applied in (so 2>&1 > f and > f 2>&1 differ)
+  int num_redirects;
+} stage_t;
+
+// programs connected by pipes, run in the foreground or (when followed by &) in the background
+typedef struct pipeline
+{
+  stage_t *stages;
+  int num_stages;
+  int background;
+  int timed;           // whether it started with time (which isn't part of its first stage)
+  int substitutions;   // whether any of its words is a substitution $( ... ), which has yet to be replaced by its output
+  char *const *tokens; // the tokens the pipeline was parsed from, for describing it (as a job, for instance)
+  int num_tokens;
+} pipeline_t;
+
+// every pipeline of a command, in the order they are to be run
+typedef struct command
+{
+  pipeline_t *pipelines;
+  int num_pipelines;
+} command_t;
+
+// parsing the tokens of a command (with types[n] the type of tokens[n]) in a single pass
+// the command points into the tokens, which have to stay around until it is freed with free_command
+// returns 0, or -1 (after saying what is wrong) if the command can't be run, in which case there is nothing to free
+int parse_command(char *const *tokens, const unsigned char *types, command_t *command);
+
+// freeing the memory held by a parsed command
+void free_command(command_t *command);
+
+#endif /* _PARSE_H */
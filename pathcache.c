@@ -0,0 +1,265 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sys/stat.h>
+
+// ************** Including the necessary header file **************
+
+#include "pathcache.h"
+
+// ************** Define macros **************
+
+// the initial number of slots in the table (always a power of two, so that a hash can be masked into a slot)
+#define INITIAL_SLOTS 64
+
+// ************** Define global variables **************
+
+// a single command remembered by the cache
+struct path_entry
+{
+  char *name;        // the name the command was entered with (NULL for an empty slot)
+  char *path;        // the absolute path it was found at
+  unsigned long hits; // how many times the cached path was used
+};
+
+static struct path_entry *slots = NULL; // the hash table, using open addressing with linear probing
+static size_t num_slots;                // total capacity of the table
+static size_t num_entries;              // number of slots in use
+static char *cached_path_var = NULL;    // the value of $PATH the cached entries were resolved against
+
+static unsigned long cache_hits;   // lookups answered by the table
+static unsigned long cache_misses; // lookups which had to search $PATH
+
+// ************** Declaring the necessary functions **************
+
+static size_t hash_name(const char *name);
+static struct path_entry *find_slot(const char *name);
+static void grow_slots();
+static char *search_path(const char *name, const char *path_var);
+static void remove_entry(struct path_entry *entry);
+
+// ************** Defining the declared functions **************
+
+// hashing a command name (FNV-1a)
+
+static size_t hash_name(const char *name)
+{
+  size_t hash = 14695981039346656037ULL;
+  while (*name)
+  {
+    hash ^= (unsigned char)*name++;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// finding the slot holding the given name, or the empty slot where it would go
+
+static struct path_entry *find_slot(const char *name)
+{
+  size_t index = hash_name(name) & (num_slots - 1);
+
+  while (slots[index].name != NULL && strcmp(slots[index].name, name) != 0)
+  {
+    index = (index + 1) & (num_slots - 1);
+  }
+  return &slots[index];
+}
+
+// doubling the size of the table once it is more than half full, and re-inserting every entry
+
+static void grow_slots()
+{
+  struct path_entry *old_slots = slots;
+  size_t old_num_slots = num_slots;
+
+  num_slots = (old_slots == NULL) ? INITIAL_SLOTS : num_slots * 2;
+  slots = calloc(num_slots, sizeof(struct path_entry));
+  assert(slots != NULL);
+
+  for (size_t index = 0; index < old_num_slots; ++index)
+  {
+    if (old_slots[index].name != NULL)
+    {
+      *find_slot(old_slots[index].name) = old_slots[index];
+    }
+  }
+  free(old_slots);
+}
+
+// searching every directory in $PATH for an executable with the given name, the same way execvp does
+// returns a newly allocated absolute path, or NULL if there is none
+
+static char *search_path(const char *name, const char *path_var)
+{
+  size_t name_len = strlen(name);
+  const char *dir = path_var;
+
+  while (1)
+  {
+    const char *end = strchr(dir, ':');
+    size_t dir_len = (end != NULL) ? (size_t)(end - dir) : strlen(dir);
+
+    // an empty entry in $PATH stands for the current directory
+    char *candidate = malloc(dir_len + name_len + 3);
+    assert(candidate != NULL);
+    if (dir_len == 0)
+    {
+      strcpy(candidate, "./");
+    }
+    else
+    {
+      memcpy(candidate, dir, dir_len);
+      candidate[dir_len] = '/';
+      candidate[dir_len + 1] = '\0';
+    }
+    strcat(candidate, name);
+
+    struct stat info;
+    if (stat(candidate, &info) == 0 && S_ISREG(info.st_mode) && access(candidate, X_OK) == 0)
+    {
+      return candidate;
+    }
+    free(candidate);
+
+    if (end == NULL)
+    {
+      return NULL;
+    }
+    dir = end + 1;
+  }
+}
+
+// removing a single entry, re-inserting the ones after it so that probing still finds them
+
+static void remove_entry(struct path_entry *entry)
+{
+  size_t index = entry - slots;
+
+  free(entry->name);
+  free(entry->path);
+  entry->name = NULL;
+  num_entries--;
+
+  index = (index + 1) & (num_slots - 1);
+  while (slots[index].name != NULL)
+  {
+    struct path_entry moved = slots[index];
+    slots[index].name = NULL;
+    *find_slot(moved.name) = moved;
+    index = (index + 1) & (num_slots - 1);
+  }
+}
+
+// finding the absolute path of a command through the cache
+
+const char *path_lookup(const char *name)
+{
+  // a name with a slash in it is never searched for in $PATH
+  if (strchr(name, '/') != NULL || name[0] == '\0')
+  {
+    return NULL;
+  }
+
+  const char *path_var = getenv("PATH");
+  if (path_var == NULL)
+  {
+    path_var = "/bin:/usr/bin";
+  }
+
+  // everything we remember was resolved against the old $PATH
+  if (cached_path_var == NULL || strcmp(cached_path_var, path_var) != 0)
+  {
+    path_cache_clear();
+    cached_path_var = strdup(path_var);
+  }
+
+  if (slots == NULL)
+  {
+    grow_slots();
+  }
+
+  struct path_entry *entry = find_slot(name);
+
+  if (entry->name != NULL)
+  {
+    // a single access() makes sure the program wasn't removed since, which is still cheaper than the failed execve calls of a search
+    if (access(entry->path, X_OK) == 0)
+    {
+      entry->hits++;
+      cache_hits++;
+      return entry->path;
+    }
+    remove_entry(entry);
+  }
+
+  cache_misses++;
+
+  char *path = search_path(name, path_var);
+  if (path == NULL)
+  {
+    return NULL;
+  }
+
+  if ((num_entries + 1) * 2 > num_slots)
+  {
+    grow_slots();
+  }
+
+  entry = find_slot(name);
+  entry->name = strdup(name);
+  entry->path = path;
+  entry->hits = 0;
+  num_entries++;
+
+  return path;
+}
+
+// forgetting every cached path
+
+void path_cache_clear()
+{
+  for (size_t index = 0; index < num_slots; ++index)
+  {
+    if (slots[index].name != NULL)
+    {
+      free(slots[index].name);
+      free(slots[index].path);
+      slots[index].name = NULL;
+    }
+  }
+  num_entries = 0;
+
+  free(cached_path_var);
+  cached_path_var = NULL;
+}
+
+// printing every cached path along with how often it was used
+
+void path_cache_print()
+{
+  if (num_entries == 0)
+  {
+    printf("hash: hash table empty\n");
+  }
+  else
+  {
+    printf("hits\tcommand\n");
+    for (size_t index = 0; index < num_slots; ++index)
+    {
+      if (slots[index].name != NULL)
+      {
+        printf("%4lu\t%s\n", slots[index].hits, slots[index].path);
+      }
+    }
+  }
+  printf("lookups: %lu hits, %lu misses\n", cache_hits, cache_misses);
+}
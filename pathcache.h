@@ -0,0 +1,18 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _PATHCACHE_H
+#define _PATHCACHE_H
+
+// finding the absolute path of a command through the cache, searching $PATH only on a miss
+// returns NULL if the name contains a '/' (it is used as is) or if the command couldn't be found
+const char *path_lookup(const char *name);
+
+// forgetting every cached path
+void path_cache_clear();
+
+// printing every cached path along with how often it was used, followed by the hit/miss counters
+void path_cache_print();
+
+#endif /* _PATHCACHE_H */
@@ -0,0 +1,415 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#define _GNU_SOURCE // for mkostemp
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ************** Including the necessary header file **************
+
+#include "resultcache.h"
+
+// ************** Define macros **************
+
+#define RESULT_MAGIC 0x6d737263 // "msrc", at the start of every stored result
+#define KEY_HEX 32               // the length of the name of a stored result (its key, in hex)
+
+// the 128-bit FNV-1a offset basis and prime
+#define FNV_OFFSET (((unsigned __int128)0x6c62272e07bb0142ULL << 64) | 0x62b821756295c58dULL)
+#define FNV_PRIME (((unsigned __int128)1 << 88) | 0x13b)
+
+// ************** Define types **************
+
+// what a stored result starts with, followed by the output itself
+struct result_header
+{
+  uint32_t magic;
+  int32_t status;
+  uint64_t size;
+};
+
+// a stored result, while the directory is being looked through for the eviction
+struct stored_result
+{
+  char name[KEY_HEX + 1];
+  struct timespec used; // when it was last stored or replayed (its mtime)
+  unsigned long long size;
+};
+
+// ************** Define global variables **************
+
+static char *cache_dir;                  // NULL when there is nowhere to keep the results
+static unsigned long long cache_limit;
+static char **wanted;                    // the commands which are always cached, terminated by NULL
+static char *wanted_names;               // the copy of the names they point into
+
+static long long cache_bytes = -1;       // how much the directory holds (as of the last look through it, plus what was stored
+                                         // since), or -1 if it hasn't been looked through yet
+
+static unsigned long hits, misses, stores, uncacheable, evictions;
+
+// ************** Declaring helper functions **************
+
+static void hash_bytes(result_key_t *key, const void *data, size_t len);
+static void entry_path(char *path, size_t size, const result_key_t *key);
+static int make_dirs(const char *dir);
+static int is_result_name(const char *name);
+static long long list_results(struct stored_result **results, size_t *count);
+static int compare_used(const void *left, const void *right);
+static void evict();
+
+// ************** Defining the functions **************
+
+// setting up the cache, and splitting the names of the commands always cached
+
+void result_cache_configure(const char *dir, unsigned long long limit, const char *commands)
+{
+  free(cache_dir);
+  cache_dir = (dir != NULL && dir[0] != '\0') ? strdup(dir) : NULL;
+  cache_limit = limit;
+  cache_bytes = -1;
+
+  free(wanted);
+  free(wanted_names);
+  wanted = NULL;
+  wanted_names = (commands != NULL) ? strdup(commands) : NULL;
+  if (wanted_names == NULL)
+  {
+    return;
+  }
+
+  wanted = malloc((strlen(wanted_names) / 2 + 2) * sizeof(char *));
+  assert(wanted != NULL);
+  size_t count = 0;
+  for (char *name = strtok(wanted_names, " \t"); name != NULL; name = strtok(NULL, " \t"))
+  {
+    wanted[count++] = name;
+  }
+  wanted[count] = NULL;
+}
+
+// checking a name against the commands always cached
+
+int result_cache_wants(const char *name)
+{
+  for (char **entry = wanted; entry != NULL && *entry != NULL; ++entry)
+  {
+    if (strcmp(*entry, name) == 0)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// hashing bytes into the key with FNV-1a
+
+static void hash_bytes(result_key_t *key, const void *data, size_t len)
+{
+  const unsigned char *bytes = data;
+  unsigned __int128 hash = key->hash;
+  for (size_t index = 0; index < len; ++index)
+  {
+    hash = (hash ^ bytes[index]) * FNV_PRIME;
+  }
+  key->hash = hash;
+}
+
+// starting a key
+
+void result_key_init(result_key_t *key)
+{
+  key->hash = FNV_OFFSET;
+}
+
+// adding a field, preceded by its length
+
+void result_key_add(result_key_t *key, const void *data, size_t len)
+{
+  uint64_t length = len;
+  hash_bytes(key, &length, sizeof(length));
+  hash_bytes(key, data, len);
+}
+
+// adding what identifies the file behind a descriptor, and optionally what it holds
+
+int result_key_add_file(result_key_t *key, int fd, int hash_contents)
+{
+  struct stat info;
+  if (fstat(fd, &info) == -1)
+  {
+    return -1;
+  }
+
+  char link[64], path[PATH_MAX];
+  snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+  ssize_t len = readlink(link, path, sizeof(path));
+  result_key_add(key, path, (len > 0) ? (size_t)len : 0);
+
+  uint64_t fields[] = {fd, info.st_dev, info.st_ino, info.st_mtim.tv_sec, info.st_mtim.tv_nsec, info.st_size};
+  result_key_add(key, fields, sizeof(fields));
+
+  if (hash_contents && info.st_size > 0)
+  {
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      return -1;
+    }
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+    result_key_add(key, data, info.st_size);
+    munmap(data, info.st_size);
+  }
+  return 0;
+}
+
+// the path of the result stored under a key
+
+static void entry_path(char *path, size_t size, const result_key_t *key)
+{
+  snprintf(path, size, "%s/%016llx%016llx", cache_dir, (unsigned long long)(key->hash >> 64), (unsigned long long)key->hash);
+}
+
+// opening a stored result, checking that all of it is there
+
+int result_lookup(const result_key_t *key, int *status)
+{
+  if (cache_dir == NULL)
+  {
+    return -1;
+  }
+
+  char path[PATH_MAX];
+  entry_path(path, sizeof(path), key);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+  {
+    misses++;
+    return -1;
+  }
+
+  struct result_header header;
+  struct stat info;
+  if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || header.magic != RESULT_MAGIC || fstat(fd, &info) == -1 ||
+      (unsigned long long)info.st_size != sizeof(header) + header.size)
+  {
+    close(fd);
+    misses++;
+    return -1;
+  }
+
+  lseek(fd, sizeof(header), SEEK_SET);
+  futimens(fd, NULL); // it is now the most recently used result
+  hits++;
+  *status = header.status;
+  return fd;
+}
+
+// creating the directory along with every missing parent of it
+
+static int make_dirs(const char *dir)
+{
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s", dir);
+  for (char *slash = strchr(path + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/'))
+  {
+    *slash = '\0';
+    if (mkdir(path, 0700) == -1 && errno != EEXIST)
+    {
+      return -1;
+    }
+    *slash = '/';
+  }
+  return (mkdir(path, 0700) == -1 && errno != EEXIST) ? -1 : 0;
+}
+
+// creating the temporary file, with room left for the header
+
+int result_begin(result_writer_t *writer)
+{
+  if (cache_dir == NULL || make_dirs(cache_dir) == -1)
+  {
+    return -1;
+  }
+
+  snprintf(writer->path, sizeof(writer->path), "%s/tmp.XXXXXX", cache_dir);
+  writer->fd = mkostemp(writer->path, O_CLOEXEC);
+  if (writer->fd == -1)
+  {
+    return -1;
+  }
+  if (lseek(writer->fd, sizeof(struct result_header), SEEK_SET) == -1)
+  {
+    result_abort(writer);
+    return -1;
+  }
+  return 0;
+}
+
+// filling in the header and renaming the file into place, so that no one ever sees half a result
+
+void result_commit(result_writer_t *writer, const result_key_t *key, int status, long long size)
+{
+  struct result_header header = {RESULT_MAGIC, status, size};
+  char path[PATH_MAX];
+  entry_path(path, sizeof(path), key);
+
+  if (pwrite(writer->fd, &header, sizeof(header), 0) != sizeof(header) || rename(writer->path, path) == -1)
+  {
+    result_abort(writer);
+    return;
+  }
+  close(writer->fd);
+  stores++;
+
+  if (cache_bytes != -1)
+  {
+    cache_bytes += sizeof(header) + size;
+  }
+  if (cache_bytes == -1 || (unsigned long long)cache_bytes > cache_limit)
+  {
+    evict();
+  }
+}
+
+// removing the temporary file
+
+void result_abort(result_writer_t *writer)
+{
+  close(writer->fd);
+  unlink(writer->path);
+}
+
+// counting a run which wasn't cached
+
+void result_cache_uncacheable()
+{
+  uncacheable++;
+}
+
+// checking whether a name in the directory is that of a stored result
+
+static int is_result_name(const char *name)
+{
+  size_t len = strspn(name, "0123456789abcdef");
+  return len == KEY_HEX && name[len] == '\0';
+}
+
+// looking through the directory for every stored result
+// returns how many bytes they take up, or -1 if the directory couldn't be read
+
+static long long list_results(struct stored_result **results, size_t *count)
+{
+  DIR *dir = (cache_dir != NULL) ? opendir(cache_dir) : NULL;
+  *results = NULL;
+  *count = 0;
+  if (dir == NULL)
+  {
+    return -1;
+  }
+
+  size_t capacity = 0;
+  long long total = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL)
+  {
+    struct stat info;
+    if (!is_result_name(entry->d_name) || fstatat(dirfd(dir), entry->d_name, &info, 0) == -1)
+    {
+      continue;
+    }
+    if (*count == capacity)
+    {
+      capacity = capacity ? capacity * 2 : 64;
+      *results = realloc(*results, capacity * sizeof(**results));
+      assert(*results != NULL);
+    }
+    struct stored_result *result = &(*results)[(*count)++];
+    memcpy(result->name, entry->d_name, KEY_HEX + 1);
+    result->used = info.st_mtim;
+    result->size = info.st_size;
+    total += info.st_size;
+  }
+  closedir(dir);
+  return total;
+}
+
+// ordering stored results from the least recently used one
+
+static int compare_used(const void *left, const void *right)
+{
+  const struct timespec *a = &((const struct stored_result *)left)->used;
+  const struct timespec *b = &((const struct stored_result *)right)->used;
+  if (a->tv_sec != b->tv_sec)
+  {
+    return (a->tv_sec < b->tv_sec) ? -1 : 1;
+  }
+  return (a->tv_nsec < b->tv_nsec) ? -1 : (a->tv_nsec > b->tv_nsec);
+}
+
+// removing the least recently used results until the directory is within the limit
+// (the directory is only looked through when it may be over it, as the total is kept up to date in between)
+
+static void evict()
+{
+  struct stored_result *results;
+  size_t count;
+  cache_bytes = list_results(&results, &count);
+  if (cache_bytes > 0 && (unsigned long long)cache_bytes > cache_limit)
+  {
+    qsort(results, count, sizeof(*results), compare_used);
+    for (size_t index = 0; index < count && (unsigned long long)cache_bytes > cache_limit; ++index)
+    {
+      char path[PATH_MAX];
+      snprintf(path, sizeof(path), "%s/%s", cache_dir, results[index].name);
+      if (unlink(path) == 0)
+      {
+        cache_bytes -= results[index].size;
+        evictions++;
+      }
+    }
+  }
+  free(results);
+}
+
+// printing the counters and the size of the cache
+
+void result_cache_stats()
+{
+  struct stored_result *results;
+  size_t count;
+  long long total = list_results(&results, &count);
+  free(results);
+
+  printf("directory: %s\n", (cache_dir != NULL) ? cache_dir : "(none)");
+  printf("entries: %zu (%lld of %llu bytes)\n", count, (total > 0) ? total : 0, cache_limit);
+  printf("hits: %lu, misses: %lu, stored: %lu, evicted: %lu, uncacheable: %lu\n", hits, misses, stores, evictions, uncacheable);
+}
+
+// removing every stored result
+
+void result_cache_clear()
+{
+  struct stored_result *results;
+  size_t count;
+  list_results(&results, &count);
+  for (size_t index = 0; index < count; ++index)
+  {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", cache_dir, results[index].name);
+    unlink(path);
+  }
+  free(results);
+  cache_bytes = 0;
+}
@@ -0,0 +1,64 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _RESULTCACHE_H
+#define _RESULTCACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+
+// what a result is stored under: a 128-bit hash of everything the output of the command depends on
+typedef struct result_key
+{
+  unsigned __int128 hash;
+} result_key_t;
+
+// a result being written into the cache, in a temporary file of the cache directory until it is committed
+typedef struct result_writer
+{
+  int fd;               // where the output goes (past the room left for the header)
+  char path[PATH_MAX];  // the name of the temporary file
+} result_writer_t;
+
+// setting the cache directory (created when the first result is stored) and how many bytes it may hold, along with the names of
+// the commands which are always cached (separated by spaces, or NULL for none)
+void result_cache_configure(const char *dir, unsigned long long limit, const char *commands);
+
+// checking whether a command is one of those always cached
+int result_cache_wants(const char *name);
+
+// starting a key, and adding a field of it (each field is hashed with its length, so that "a b" and "ab" differ)
+void result_key_init(result_key_t *key);
+void result_key_add(result_key_t *key, const void *data, size_t len);
+
+// adding an input file to the key: its path, device, inode, mtime and size, and everything it holds when hash_contents is set
+// returns 0, or -1 if the descriptor couldn't be looked at
+int result_key_add_file(result_key_t *key, int fd, int hash_contents);
+
+// looking a result up, and marking it as just used (for the eviction)
+// returns a descriptor reading the stored output (with *status set to the stored exit status), or -1 on a miss
+int result_lookup(const result_key_t *key, int *status);
+
+// creating a temporary file for the output of a command
+// returns 0, or -1 if the cache directory can't be written to (the command is then run without being stored)
+int result_begin(result_writer_t *writer);
+
+// storing the output written into the writer (size bytes of it) with the exit status under the key, then evicting the least
+// recently used results until the cache is within its limit again
+void result_commit(result_writer_t *writer, const result_key_t *key, int status, long long size);
+
+// throwing a result being written away
+void result_abort(result_writer_t *writer);
+
+// counting a run which couldn't be cached (its input being a pipe, say)
+void result_cache_uncacheable();
+
+// printing the counters of this session and what the cache holds
+void result_cache_stats();
+
+// removing every stored result
+void result_cache_clear();
+
+#endif /* _RESULTCACHE_H */
@@ -0,0 +1,314 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+// ************** Including the necessary header files **************
+
+#include "scriptcache.h"
+#include "tokens.h"
+
+// ************** Define macros **************
+
+// how many parsed scripts are kept around at most (the least recently used one is dropped first)
+#define MAX_SCRIPTS 32
+#define MAX_SCRIPT_SIZE (1 << 20) // larger scripts aren't kept (their parsed form would take up a few times their size)
+
+// ************** Define global variables **************
+
+static script_t *scripts = NULL; // the cache, from most to least recently used
+static int num_scripts;          // how many scripts are in the cache
+static int cache_enabled = 1;    // whether parsed scripts are kept around at all
+
+// ************** Declaring the necessary functions **************
+
+static size_t append_chars(script_t *script, size_t *used, size_t *capacity, const char *chars, size_t count);
+static script_t *parse_script(int fd, const struct stat *info);
+static void parse_text(script_t *script, const char *text, size_t text_len);
+static void free_script(script_t *script);
+static void drop_script(script_t **link);
+
+// ************** Defining the declared functions **************
+
+// enabling or disabling the cache
+
+void script_cache_set_enabled(int enabled)
+{
+  cache_enabled = enabled;
+}
+
+// appending characters to the script's storage, returning where they start
+
+static size_t append_chars(script_t *script, size_t *used, size_t *capacity, const char *chars, size_t count)
+{
+  if (*used + count > *capacity)
+  {
+    *capacity = (*used + count > *capacity * 2) ? *used + count : *capacity * 2;
+    script->chars = realloc(script->chars, *capacity);
+    assert(script->chars != NULL);
+  }
+
+  size_t start = *used;
+  memcpy(&script->chars[start], chars, count);
+  *used += count;
+  return start;
+}
+
+// splitting the file into lines and commands, and tokenizing every command
+// the file is mapped into memory rather than read, and every command is tokenized straight out of the mapping. nothing points
+// into the mapping once the file is parsed, so the commands can do whatever they want with the file (even truncate it) while
+// the script runs.
+// returns NULL if the file couldn't be mapped
+
+static script_t *parse_script(int fd, const struct stat *info)
+{
+  script_t *script = calloc(1, sizeof(script_t));
+  assert(script != NULL);
+
+  script->dev = info->st_dev;
+  script->ino = info->st_ino;
+  script->mtime = info->st_mtim;
+  script->size = info->st_size;
+  script->refs = 1;
+
+  size_t text_len = info->st_size;
+  const char *text = "";
+  void *mapping = MAP_FAILED;
+
+  if (text_len > 0)
+  {
+    mapping = mmap(NULL, text_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+      free(script);
+      return NULL;
+    }
+    madvise(mapping, text_len, MADV_SEQUENTIAL);
+    text = mapping;
+  }
+
+  // the script ends at its first \0, just like a line read by getline would
+  const char *nul = memchr(text, '\0', text_len);
+  if (nul != NULL)
+  {
+    text_len = nul - text;
+  }
+
+  parse_text(script, text, text_len);
+
+  if (mapping != MAP_FAILED)
+  {
+    munmap(mapping, info->st_size);
+  }
+  return script;
+}
+
+// splitting the text into lines and commands, and tokenizing every command into the script
+// the lines are found with memchr, and the tokens and the text of every command are appended to the script's storage, and only
+// turned into pointers once it has stopped growing
+
+static void parse_text(script_t *script, const char *text, size_t text_len)
+{
+  size_t *offsets = NULL;      // where each token starts in chars ((size_t)-1 for the NULL ending a command)
+  size_t num_offsets = 0;
+  size_t offsets_capacity = 0;
+  size_t *first_token = NULL;  // where the tokens of each command start in offsets
+  size_t *text_offsets = NULL; // where the text of each command starts in chars
+  size_t commands_capacity = 0;
+  size_t chars_used = 0;
+  size_t chars_capacity = 0;
+
+  tokenizer_t ctx;
+  tokenizer_init(&ctx);
+
+  size_t line_start = 0;
+  while (line_start < text_len)
+  {
+    const char *line = &text[line_start];
+    const char *newline = memchr(line, '\n', text_len - line_start);
+    size_t line_len = (newline != NULL) ? (size_t)(newline - line) + 1 : text_len - line_start;
+    int first_of_line = 1;
+
+    size_t start = 0;
+    while (start < line_len)
+    {
+      size_t cmd_len = command_length(&line[start], line_len - start);
+      char **tokens = tokenize_into(&ctx, &line[start], cmd_len);
+
+      // a command made of nothing but spaces is never run, so it isn't kept
+      if (tokens[0] != NULL)
+      {
+        if (script->num_commands == commands_capacity)
+        {
+          commands_capacity = commands_capacity ? commands_capacity * 2 : 64;
+          script->commands = realloc(script->commands, sizeof(script_command_t) * commands_capacity);
+          first_token = realloc(first_token, sizeof(size_t) * commands_capacity);
+          text_offsets = realloc(text_offsets, sizeof(size_t) * commands_capacity);
+          assert(script->commands != NULL && first_token != NULL && text_offsets != NULL);
+        }
+
+        script_command_t *command = &script->commands[script->num_commands];
+        command->text_len = cmd_len;
+        command->first_of_line = first_of_line;
+        first_token[script->num_commands] = num_offsets;
+        text_offsets[script->num_commands] = append_chars(script, &chars_used, &chars_capacity, &line[start], cmd_len);
+        append_chars(script, &chars_used, &chars_capacity, "", 1);
+        script->num_commands++;
+        first_of_line = 0;
+
+        // copying the tokens (and the NULL after them) over
+        size_t needed = num_offsets + ctx.arena.num_tokens + 1;
+        if (needed > offsets_capacity)
+        {
+          offsets_capacity = (needed > offsets_capacity * 2) ? needed : offsets_capacity * 2;
+          offsets = realloc(offsets, sizeof(size_t) * offsets_capacity);
+          script->types = realloc(script->types, offsets_capacity);
+          assert(offsets != NULL && script->types != NULL);
+        }
+        size_t chars_start = append_chars(script, &chars_used, &chars_capacity, ctx.arena.chars, ctx.arena.chars_used);
+        memcpy(&script->types[num_offsets], ctx.arena.types, ctx.arena.num_tokens);
+        for (size_t index = 0; index < ctx.arena.num_tokens; ++index)
+        {
+          offsets[num_offsets++] = chars_start + (tokens[index] - ctx.arena.chars);
+        }
+        script->types[num_offsets] = TOKEN_WORD; // nothing ever looks at the type of the NULL
+        offsets[num_offsets++] = (size_t)-1;
+      }
+
+      start += cmd_len + 1; // skip over the ; as well
+    }
+
+    line_start += line_len;
+  }
+
+  tokenizer_free(&ctx);
+
+  // now that the characters have stopped moving, every token (and every command) can point straight at them
+  script->tokens = malloc(sizeof(char *) * (num_offsets + 1));
+  assert(script->tokens != NULL);
+  for (size_t index = 0; index < num_offsets; ++index)
+  {
+    script->tokens[index] = (offsets[index] == (size_t)-1) ? NULL : &script->chars[offsets[index]];
+  }
+  for (size_t index = 0; index < script->num_commands; ++index)
+  {
+    script->commands[index].tokens = &script->tokens[first_token[index]];
+    script->commands[index].types = &script->types[first_token[index]];
+    script->commands[index].text = &script->chars[text_offsets[index]];
+  }
+
+  free(offsets);
+  free(first_token);
+  free(text_offsets);
+}
+
+// parsing the text of len bytes into a script of its own, outside of the cache
+
+script_t *script_parse(const char *text, size_t len)
+{
+  script_t *script = calloc(1, sizeof(script_t));
+  assert(script != NULL);
+  script->refs = 1;
+  parse_text(script, text, len);
+  return script;
+}
+
+// freeing everything held by a script
+
+static void free_script(script_t *script)
+{
+  free(script->commands);
+  free(script->tokens);
+  free(script->types);
+  free(script->chars);
+  free(script);
+}
+
+// taking a script out of the cache (it is only freed once nobody is running it anymore)
+
+static void drop_script(script_t **link)
+{
+  script_t *script = *link;
+  *link = script->next;
+  num_scripts--;
+  script_release(script);
+}
+
+// getting the parsed form of the regular file open at fd
+
+script_t *script_load(int fd, const struct stat *info)
+{
+  if (!cache_enabled || !S_ISREG(info->st_mode) || info->st_size > MAX_SCRIPT_SIZE)
+  {
+    return NULL;
+  }
+
+  // scripts are told apart by the file they were read from (rather than the path, which depends on the current directory)
+  script_t **link = &scripts;
+  while (*link != NULL)
+  {
+    script_t *script = *link;
+
+    if (script->dev == info->st_dev && script->ino == info->st_ino)
+    {
+      if (script->size == info->st_size && script->mtime.tv_sec == info->st_mtim.tv_sec &&
+          script->mtime.tv_nsec == info->st_mtim.tv_nsec)
+      {
+        // moving it to the front, as the most recently used script
+        *link = script->next;
+        script->next = scripts;
+        scripts = script;
+
+        script->refs++;
+        return script;
+      }
+
+      // the file has changed since it was parsed
+      drop_script(link);
+      break;
+    }
+    link = &script->next;
+  }
+
+  script_t *script = parse_script(fd, info);
+  if (script == NULL)
+  {
+    return NULL; // (it is run as it is read instead, and is tried again the next time)
+  }
+
+  if (num_scripts == MAX_SCRIPTS)
+  {
+    link = &scripts;
+    while ((*link)->next != NULL)
+    {
+      link = &(*link)->next;
+    }
+    drop_script(link);
+  }
+
+  script->next = scripts;
+  scripts = script;
+  num_scripts++;
+
+  script->refs++; // one reference for the cache, one for the caller
+  return script;
+}
+
+// giving back a script obtained through script_load
+
+void script_release(script_t *script)
+{
+  if (--script->refs == 0)
+  {
+    free_script(script);
+  }
+}
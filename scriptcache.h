@@ -0,0 +1,60 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _SCRIPTCACHE_H
+#define _SCRIPTCACHE_H
+
+#include <stddef.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// a single command of a script, already split off from the others and tokenized
+typedef struct script_command
+{
+  char **tokens;     // the tokens of the command, terminated by NULL (never empty)
+  unsigned char *types; // the type of each token (see tokens.h)
+  const char *text;  // the text of the command (followed by a \0), for checking whether it sources the script itself
+  size_t text_len;
+  int first_of_line; // whether the command starts its line (which is then where the line is checked before it runs)
+} script_command_t;
+
+// a script parsed into its commands, which can be run any number of times without reading or tokenizing it again
+typedef struct script
+{
+  // what the script was parsed from: if any of these change, the file has to be parsed again
+  dev_t dev;
+  ino_t ino;
+  struct timespec mtime;
+  off_t size;
+
+  script_command_t *commands; // every command of the script, in order
+  size_t num_commands;
+  char **tokens; // the tokens of every command, one NULL-terminated run after another
+  unsigned char *types; // the type of every token, in step with tokens
+  char *chars;   // the characters of every token and the text of every command
+
+  int refs;            // how many users the script has (the cache counts as one)
+  struct script *next; // the next script in the cache, from most to least recently used
+} script_t;
+
+// getting the parsed form of the file open at fd (as described by fstat in info), from the cache if it hasn't changed since
+// it was parsed. fd is left open, and the file is only ever looked at through it, so a FIFO isn't opened twice.
+// returns NULL if the file isn't a regular file, is too large to be kept (over 1 MB), couldn't be mapped or the cache is disabled,
+// in which case it should be run as it is read
+// the script has to be given back with script_release once it has been run
+script_t *script_load(int fd, const struct stat *info);
+
+// parsing the first len bytes of text (a line, or several of them) the same way as a script, into a script of its own which isn't
+// kept in the cache (nothing points into text afterwards)
+// the script has to be given back with script_release
+script_t *script_parse(const char *text, size_t len);
+
+// giving back a script obtained through script_load or script_parse
+void script_release(script_t *script);
+
+// enabling or disabling the cache (it starts out enabled)
+void script_cache_set_enabled(int enabled);
+
+#endif /* _SCRIPTCACHE_H */
@@ -0,0 +1,204 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#define _GNU_SOURCE // for accept4, pipe2 and MSG_CMSG_CLOEXEC
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+
+// ************** Including the necessary header file **************
+
+#include "server.h"
+
+// ************** Declaring helper functions **************
+
+static int read_all(int fd, void *buffer, size_t size);
+static int receive_request(int conn, int fds[3], char **commands, size_t *len);
+static void serve_one(int listener, int notify, pid_t zygote, server_runner_t run);
+
+// ************** Defining the functions **************
+
+// reading exactly size bytes
+// returns 0, or -1 if reading failed or the other end closed the connection first
+
+static int read_all(int fd, void *buffer, size_t size)
+{
+  char *cursor = buffer;
+  while (size > 0)
+  {
+    ssize_t got = read(fd, cursor, size);
+    if (got == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (got <= 0)
+    {
+      return -1;
+    }
+    cursor += got;
+    size -= got;
+  }
+  return 0;
+}
+
+// receiving a request: its header along with the client's stdin, stdout and stderr, then its commands (followed by a \0)
+// returns 0, or -1 if the request is malformed (or the client went away)
+
+static int receive_request(int conn, int fds[3], char **commands, size_t *len)
+{
+  server_request_t header;
+  char control[CMSG_SPACE(3 * sizeof(int))];
+  struct iovec part = {&header, sizeof(header)};
+  struct msghdr message = {.msg_iov = &part, .msg_iovlen = 1, .msg_control = control, .msg_controllen = sizeof(control)};
+
+  ssize_t got;
+  while ((got = recvmsg(conn, &message, MSG_CMSG_CLOEXEC | MSG_WAITALL)) == -1 && errno == EINTR)
+  {
+  }
+  struct cmsghdr *rights = (got == sizeof(header)) ? CMSG_FIRSTHDR(&message) : NULL;
+  if (rights == NULL || rights->cmsg_level != SOL_SOCKET || rights->cmsg_type != SCM_RIGHTS ||
+      rights->cmsg_len != CMSG_LEN(3 * sizeof(int)))
+  {
+    return -1;
+  }
+  memcpy(fds, CMSG_DATA(rights), 3 * sizeof(int));
+
+  if (header.magic != SERVER_MAGIC || header.length > SERVER_MAX_COMMANDS)
+  {
+    return -1;
+  }
+  *len = header.length;
+  *commands = malloc(*len + 1);
+  if (*commands == NULL || read_all(conn, *commands, *len) == -1)
+  {
+    return -1;
+  }
+  (*commands)[*len] = '\0';
+  return 0;
+}
+
+// waiting for a connection as the spare worker, then telling the zygote to fork the next one, and serving the request
+// never returns
+
+static void serve_one(int listener, int notify, pid_t zygote, server_runner_t run)
+{
+  // a worker which is still waiting goes away along with the zygote (which may have gone before this was set)
+  prctl(PR_SET_PDEATHSIG, SIGTERM);
+  if (getppid() != zygote)
+  {
+    _exit(0);
+  }
+
+  int conn;
+  while ((conn = accept4(listener, NULL, NULL, SOCK_CLOEXEC)) == -1 && errno == EINTR)
+  {
+  }
+  prctl(PR_SET_PDEATHSIG, 0);
+  while (write(notify, "", 1) == -1 && errno == EINTR)
+  {
+  }
+  close(notify);
+  close(listener);
+
+  int fds[3];
+  char *commands;
+  size_t len;
+  if (conn == -1 || receive_request(conn, fds, &commands, &len) == -1)
+  {
+    _exit(1);
+  }
+
+  for (int fd = 0; fd < 3; ++fd)
+  {
+    dup2(fds[fd], fd);
+    if (fds[fd] != fd)
+    {
+      close(fds[fd]);
+    }
+  }
+
+  int32_t status = run(commands, len);
+  fflush(stdout);
+  send(conn, &status, sizeof(status), MSG_NOSIGNAL);
+  _exit(status);
+}
+
+// serving requests on a Unix socket at path until the process is killed
+
+int server_run(const char *path, server_runner_t run)
+{
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  if (strlen(path) >= sizeof(address.sun_path))
+  {
+    fprintf(stderr, "%s: the path of the socket is too long\n", path);
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+
+  // a socket left behind by a server which was killed
+  struct stat info;
+  if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode))
+  {
+    unlink(path);
+  }
+
+  int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listener == -1 || bind(listener, (struct sockaddr *)&address, sizeof(address)) == -1 || listen(listener, SOMAXCONN) == -1)
+  {
+    perror(path);
+    return -1;
+  }
+
+  pid_t zygote = getpid();
+  while (1)
+  {
+    // every worker gets a pipe of its own, which it writes a byte into once it has taken a connection; the zygote keeps only the
+    // read end of it, so that the pipe is closed as soon as the worker goes away, even if it dies before taking one
+    int notify[2];
+    if (pipe2(notify, O_CLOEXEC) == -1)
+    {
+      perror("Error creating pipe");
+      sleep(1);
+      continue;
+    }
+
+    fflush(stdout); // (nothing buffered by the zygote may come out of every worker)
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      close(notify[0]);
+      serve_one(listener, notify[1], zygote, run);
+    }
+    close(notify[1]);
+    if (pid == -1)
+    {
+      close(notify[0]);
+      perror("Error starting worker");
+      sleep(1);
+      continue;
+    }
+
+    // waiting for the worker to take a connection (or to die without one, which the end of the pipe tells), then reaping the
+    // workers which are done by now; either way, the next worker is forked right away
+    char byte;
+    while (read(notify[0], &byte, 1) == -1 && errno == EINTR)
+    {
+    }
+    close(notify[0]);
+    while (waitpid(-1, NULL, WNOHANG) > 0)
+    {
+    }
+  }
+}
@@ -0,0 +1,36 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _SERVER_H
+#define _SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// what a client sends over the socket: this header, along with its stdin, stdout and stderr (passed as SCM_RIGHTS, so the commands
+// read and write them directly, and nothing they print goes through the server), followed by the commands themselves
+// once the commands are done, the client gets their exit status back as an int32_t
+typedef struct server_request
+{
+  uint32_t magic;  // SERVER_MAGIC
+  uint32_t length; // how many bytes of commands follow
+} server_request_t;
+
+#define SERVER_MAGIC 0x6d736831 // "msh1"
+#define SERVER_MAX_COMMANDS (64 << 20) // the longest commands a request can hold
+
+// what runs the commands of a request (of len bytes, followed by a \0), in the worker which took it, once its stdin, stdout and
+// stderr are those of the client
+// returns the exit status of the commands
+typedef int (*server_runner_t)(const char *commands, size_t len);
+
+// serving requests on a Unix socket at path (replacing a stale socket left there) until the process is killed
+// the calling process is the zygote: it never runs a request itself, but keeps a worker forked from it (and so sharing everything
+// it has loaded) waiting in accept. as soon as that worker takes a connection, the zygote forks the next one, so there is always a
+// warm worker waiting, and the cost of forking is never paid while a client waits (a worker dying before it takes one is replaced
+// just the same).
+// returns -1 if the socket couldn't be set up (with the reason printed)
+int server_run(const char *path, server_runner_t run);
+
+#endif /* _SERVER_H */
@@ -10,34 +10,91 @@
 #include <unistd.h>
 #include <assert.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 // ************** Including the necessary header file **************
 
 #include "tokens.h" // for importing the token-parsing funtionalities
+#include "spawn.h"  // for launching programs with the selected backend
+#include "pathcache.h" // for the table of command paths behind the hash builtin
+#include "scriptcache.h" // for running scripts which have already been parsed
+#include "jobs.h" // for the commands running in the background
+#include "parallel.h" // for the parallel builtin
+#include "builtins.h" // for the utilities run by the shell itself
+#include "parse.h" // for turning the tokens of a command into its pipelines
+#include "stats.h" // for timing commands (time) and the parts of running them (stats)
+#include "trace.h" // for the trace of everything the shell does (MINISHELL_TRACE)
+#include "subst.h" // for capturing the output of command substitutions $( ... )
+#include "history.h" // for the history of the lines entered at the prompt (history, !n, !prefix and prev)
+#include "server.h" // for serving commands from clients over a Unix socket (--server)
+#include "copy.h" // for copying the output of cached commands inside the kernel
+#include "resultcache.h" // for the cache of the results of commands (cached and cache)
 
-// ************** Defining the macro **************
+// ************** Defining the global variable **************
 
-#define LINE_LENGTH 256 // maximum length of a line, in bytes (as instructed in project description)
+// the number of the history entry being run: 0 when the line isn't in the history, HISTORY_LAST for the line just entered
+size_t currentEntry = 0;
+int interactive = 1; // whether the shell is reading commands at its prompt (rather than from -c or a script file)
+int lastStatus = 0; // the exit status of the last command run in the foreground (what a subshell exits with)
+const stage_t *launchingGroup = NULL; // the group ( ... ) being launched, for runGroup to find in the subshell forked for it
+struct stat shellInput; // what the shell's own stdin was when it started, which cached commands never read
 
-// ************** Defining the global variable **************
+// ************** Define macros **************
 
-char cachedPrevCmd[256]; // for 'caching' the previous command
+// the highest descriptor a redirection can name (n> file, n>&m), just like in sh
+#define MAX_REDIRECT_FD 9
 
-// ************** Defining the necessary functions **************
+// stands for the last entry of the history in currentEntry
+#define HISTORY_LAST ((size_t)-1)
+
+// ************** Defining the builtins **************
 
-// to exit the shell when "exit" is entered on the shell
-int isExit(const char *cmd)
+// how many slots the table of builtins has (a power of two, at least twice the number of builtins)
+#define BUILTIN_SLOTS 64
+
+// a command the shell runs itself, rather than launching a program for it
+typedef struct builtin
 {
-  int check = strcmp("exit", cmd);
+  const char *name;
+  int (*run)(char *const *argv); // runs the builtin, with argv[0] being its name
+  // whether it acts like a program (its result is an exit status, and it can be remembered as the previous command), rather than
+  // changing the shell itself (its result is 1 for leaving the shell)
+  int utility;
+} builtin_t;
+
+// ************** Declaring the necessary functions **************
+
+const builtin_t *findBuiltin(const char *name);
+const builtin_t *findStageBuiltin(char *const *argv);
+int execCmd(const char *const *tokens, run_usage_t *usage);
+int sepCommmand(const char *line, size_t len);
+int manageShell(const char *const *tokens, const unsigned char *types);
+int runScript(const script_t *script, const char *path);
+int runGroup(char *const *argv);
+int runCommandString(const char *cmd);
+
+// ************** Defining the necessary functions **************
 
-  if (check == 0)
+// to exit the shell when "exit" is entered on the shell, with the given status (or that of the last command) when not at the prompt
+int builtinExit(char *const *argv)
+{
+  if (argv[1] != NULL)
+  {
+    lastStatus = atoi(argv[1]) & 0xff;
+  }
+  if (interactive)
   {
     printf("Bye bye.\n");
   }
-
-  return check;
+  return 1;
 }
 
 // changes the current working directory to the specified path
@@ -51,562 +108,1814 @@ int isCd(const char *path)
   }
 }
 
-// to print the previous command when "prev" is entered on the shell
-int isPrev(char *cmd)
+// To print and execute an entry of the history again, from its parsed form (which is kept for the next time it is replayed)
+// Terminates if one of its commands was exit
+int execEntry(size_t number)
 {
-  int check = strcmp("prev", cmd);
+  size_t len;
+  const char *text = history_get(number, &len);
+  printf("%.*s\n", (int)len, text);
+
+  script_t *script = history_parsed(number);
+  size_t outerEntry = currentEntry;
+  currentEntry = number; // a prev within the entry runs the one before it
+  int result = runScript(script, NULL);
+  currentEntry = outerEntry;
+  script_release(script);
+  return result;
+}
 
-  if (check == 0)
+// to print and execute the previous command line when "prev" is entered on the shell
+// (the line before the one being run, which is the last entry of the history unless the line was added to it)
+int builtinPrev(char *const *argv)
+{
+  (void)argv;
+  size_t number = history_count();
+  if (currentEntry == HISTORY_LAST)
+  {
+    number--;
+  }
+  else if (currentEntry != 0)
   {
-    printf("%s\n", cachedPrevCmd);
+    number = currentEntry - 1;
   }
 
-  return check;
+  if (number == 0)
+  {
+    printf("No command has been entered previously!\n");
+    return 0;
+  }
+  return execEntry(number);
 }
 
-// To execute the previous command, if available
-void execPrev(char *prevCmd)
+// to list the entries of the history (only the last n of them with history n) when "history" is entered on the shell
+int builtinHistory(char *const *argv)
 {
-  if (prevCmd == NULL)
+  size_t count = history_count();
+  size_t first = 1;
+
+  if (argv[1] != NULL)
   {
-    printf("No command has been entered previously!\n");
+    char *end;
+    unsigned long last = strtoul(argv[1], &end, 10);
+    if (*end != '\0' || argv[1][0] == '-')
+    {
+      printf("history: %s: numeric argument required\n", argv[1]);
+      return 1;
+    }
+    first = (last < count) ? count - last + 1 : 1;
   }
-  else
+
+  for (size_t number = first; number <= count; ++number)
   {
-    char **prevCmdTokens = create_tokens(prevCmd); // creating tokens from the previous command
-    execCmd(prevCmdTokens);                        // executing the previous command
-    free_tokens(prevCmdTokens);                    // freeing the memory occupied by the previous command
+    size_t len;
+    const char *text = history_get(number, &len);
+    printf("%5zu  %.*s\n", number, (int)len, text);
   }
+  return 0;
 }
 
 // to print the help menu when "help" is entered on the shell
-int isHelp(char *cmd)
+int builtinHelp(char *const *argv)
 {
-  int check = strcmp(cmd, "help");
+  (void)argv;
+  printf("Displaying help menu:\n Available built-in commands:\n cd [dir-path, ..] : This command should change the current working directory  the shell to the path specified as the argument.\n source [file-path] : Execute a script.\n Takes a filename as an argument and processes each line  the file as a command, including built-ins. In other word each line should be processed as if it was entered by t user at the prompt.\n prev : Prints the previous command line and executes it again without becoming the new command line.\n history [n] : Lists the lines entered at the prompt (the last n of them), kept in ~/.minishell_history (or in $MINISHELL_HISTORY) across sessions.\n !n, !-n, !!, !prefix : Runs again the line numbered n, the n-th last one, the last one, or the last one starting with prefix.\n hash [-r] [name ..] : Lists the remembered paths of commands with the hit/miss counters, forgets them all (-r), or looks the given commands up in advance.\n spawn [fork|posix] : Shows or selects how programs are launched (fork + exec, or posix_spawn).\n ( cmd1; cmd2 ) : Runs the commands in a subshell of their own, to which redirections and pipes apply as a whole.\n $(cmd) : Runs cmd in a subshell, and puts the words of its output in its place, glued to the text around it (inside quotation marks, the whole output is a single word).\n cmd & : Runs the command in the background as a new job.\n jobs : Lists the jobs along with their state.\n wait [%%n] : Waits for the given job, or for every job.\n fg [%%n] / bg [%%n] : Continues a job (the most recent one by default) in the foreground/background.\n echo, true, false, test/[, printf, pwd, tee [-a] : Run by the shell itself, without launching a program (as is cat without options, which copies the files inside the kernel).\n parallel [-j N] [-k] [--fail-fast] cmd [args ..] [::: inputs ..] : Runs cmd once per input (read from stdin without :::), N at a time ({} is replaced with the input).\n time cmd : Runs cmd (which can be a pipeline), then prints the real, user and sys time and the peak memory of it and of each of its stages.\n stats [-r] [tokenize|parse|lookup|spawn|wait|command] : Shows how long the parts of running commands have taken so far (or the histogram of one of them), or forgets it all (-r).\n cached [-h] cmd [args ..] : Replays the output and exit status of cmd from ~/.cache/minishell (or $MINISHELL_CACHE_DIR) when it was run before on the same input files (compared by their contents with -h), without running it; the commands named in $MINISHELL_CACHE_COMMANDS are always cached.\n cache [stats|clear] : Shows the hits and misses of the cache along with what it holds, or empties it.\n help : Explains all the built-in commands available in the shell\n exit [n] : Exit the shell (with status n, outside of the prompt).\n");
+  return 0;
+}
 
-  if (check == 0)
+// to show or select the backend used for launching programs when "spawn" is entered on the shell
+void execSpawn(const char *name)
+{
+  if (name == NULL)
   {
-    printf("Displaying help menu:\n Available built-in commands:\n cd [dir-path, ..] : This command should change the current working directory  the shell to the path specified as the argument.\n source [file-path] : Execute a script.\n Takes a filename as an argument and processes each line  the file as a command, including built-ins. In other word each line should be processed as if it was entered by t user at the prompt.\n prev : Prints the previous command line and executes it again without becoming the new command line.\n help : Explains all the built-in commands available in the shell\n exit : Exit the shell.\n");
+    printf("%s\n", spawn_backend_name(spawn_get_backend()));
+    return;
   }
 
-  return check;
+  int backend = spawn_backend_from_name(name);
+
+  if (backend == -1)
+  {
+    printf("Unknown spawn backend '%s' (expected fork or posix).\n", name);
+  }
+  else
+  {
+    spawn_set_backend(backend);
+  }
 }
 
-// To handle cases with redirection
-int isRedirect(const char *const *tokens)
+// to list, clear or pre-warm the table of command paths when "hash" is entered on the shell
+void execHash(const char *const *tokens)
 {
-  int index = 0;
-
-  // iterating over the token to check if there is any redirection
-  while (tokens[index] != NULL)
+  if (tokens[1] == NULL)
   {
-    if (strcmp(tokens[index], ">") == 0)
-    {
-      return 1; // for output redirection
-    }
-    else if (strcmp(tokens[index], "<") == 0)
+    path_cache_print();
+  }
+  else if (strcmp(tokens[1], "-r") == 0)
+  {
+    path_cache_clear();
+  }
+  else
+  {
+    for (int index = 1; tokens[index] != NULL; ++index)
     {
-      return 0; // for input redirection
+      if (path_lookup(tokens[index]) == NULL)
+      {
+        printf("hash: %s: not found\n", tokens[index]);
+      }
     }
-    index++;
   }
-  return -1; // for no redirection
 }
 
-// to execute the command which includes redirection
-int execRedirect(const char *const *tokens, int type)
+// to get the function running a builtin in a child of the shell (as a stage of a pipeline or in the background), or NULL if argv
+// isn't run by a builtin. A builtin changing the shell itself (such as cd) then only changes the child, just like in any other shell.
+int (*childBuiltin(char *const *argv))(char *const *argv)
 {
-  int index = 0;
-  char *redirectionTokens[20]; // basically holding tokens for redirection, excluding the redirection command itself
-  char *file;                  // output file
+  const builtin_t *builtin = findStageBuiltin(argv);
+  return builtin != NULL ? builtin->run : NULL;
+}
 
-  // populating redirectionTokens with the relevant tokens
-  while ((strcmp(tokens[index], ">") != 0) && (strcmp(tokens[index], "<") != 0))
+// runs a builtin in the shell itself, measuring what it used up into usage (unless it is NULL)
+// returns the result of the builtin
+int runBuiltin(const builtin_t *builtin, char *const *argv, run_usage_t *usage)
+{
+  if (usage == NULL)
   {
-    redirectionTokens[index] = tokens[index];
-    index++;
+    return builtin->run(argv);
   }
 
-  redirectionTokens[index] = NULL;
+  usage_mark_t mark;
+  usage_start(&mark);
+  int result = builtin->run(argv);
+  usage_stop(&mark, usage);
+  return result;
+}
+
+// waits for a program launched in the foreground at start (from stats_now), measuring what it used up into usage (unless it is NULL)
+// returns the pid, or -1 if it couldn't be waited for
+pid_t waitForeground(pid_t pid, int *status, uint64_t start, run_usage_t *usage)
+{
+  struct rusage rusage;
+  uint64_t waitStart = stats_now();
+  pid_t result;
 
-  if (tokens[index + 1] != NULL)
+  while ((result = wait4(pid, status, 0, (usage != NULL) ? &rusage : NULL)) == -1 && errno == EINTR)
   {
-    file = tokens[index + 1]; // extracting the name of the given file for redirection to read from/write to
   }
-  else
+
+  stats_record(STAT_WAIT, waitStart);
+  if (result != -1)
+  {
+    trace_event(TRACE_CHILD_EXIT, NULL, pid, *status);
+  }
+  if (result != -1 && usage != NULL)
   {
-    return -1; // exit function as no file was given for redirection
+    usage_from_rusage(usage, &rusage, start);
   }
+  return result;
+}
 
-  pid_t pid;
-  pid = fork();
-  int state_check;
+// turns a wait status into an exit status, as $? would hold it: the status the program exited with, or 128 + the signal which
+// terminated it
+int exitStatus(int status)
+{
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+// turns the result of a utility builtin into an exit status (anything out of range counts as a failure)
+int builtinStatus(int result)
+{
+  return (result >= 0 && result <= 255) ? result : 1;
+}
+
+// runs a builtin in the shell itself, with its descriptors temporarily redirected by the numDups dups (see openRedirects)
+// returns the result of the builtin
+int runRedirectedBuiltin(const builtin_t *builtin, char *const *argv, const spawn_dup_t *dups, int numDups, run_usage_t *usage)
+{
+  fflush(stdout); // whatever the shell printed so far still goes to the real stdout
 
-  if (pid == 0)
+  // each descriptor is put aside before it first changes (-1 if it wasn't open), so that it can be put back afterwards
+  int saved[MAX_REDIRECT_FD + 1];
+  int changed[MAX_REDIRECT_FD + 1] = {0};
+  for (int index = 0; index < numDups; ++index)
   {
-    if (close(type) == -1)
+    int fd = dups[index].fd;
+    if (!changed[fd])
     {
-      perror("Error closing std");
-      exit(1);
+      saved[fd] = fcntl(fd, F_DUPFD_CLOEXEC, MAX_REDIRECT_FD + 1);
+      changed[fd] = 1;
     }
+    if (dups[index].source == -1)
+    {
+      close(fd);
+    }
+    else
+    {
+      dup2(dups[index].source, fd);
+    }
+  }
 
-    int fwd; // file descriptor for holding the given file
+  int result = runBuiltin(builtin, argv, usage);
 
-    // for output redirection
-    if (type == 1)
+  fflush(stdout);
+  for (int fd = 0; fd <= MAX_REDIRECT_FD; ++fd)
+  {
+    if (changed[fd] && saved[fd] != -1)
     {
-      fwd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      dup2(saved[fd], fd);
+      close(saved[fd]);
     }
-    // for input redirection
-    else if (type == 0)
+    else if (changed[fd])
     {
-      fwd = open(file, O_RDONLY);
+      close(fd);
     }
+  }
+  return result;
+}
 
-    assert(fwd == type);
-
-    if (execvp(redirectionTokens[0], redirectionTokens) != NULL)
+// closes the files opened for the redirections of a stage by openRedirects (for the first num of them), and frees dups
+void closeRedirects(const stage_t *stage, spawn_dup_t *dups, int num)
+{
+  for (int index = 0; index < num; ++index)
+  {
+    if (stage->redirects[index].type != REDIRECT_DUP)
     {
-      exit(1);
+      close(dups[index].source);
     }
   }
-  else
+  free(dups);
+}
+
+// checks whether a descriptor is open in the shell and handed down to what it launches (every descriptor of the shell's own,
+// such as the trace file, is closed on exec, so `>&3` can't reach it)
+int isInherited(int fd)
+{
+  int flags = fcntl(fd, F_GETFD);
+  return flags != -1 && !(flags & FD_CLOEXEC);
+}
+
+// opens the file of every redirection of a stage, in order, and turns each of them into a change to the descriptors of the stage,
+// which go into *dups (NULL when there is no redirection), to be applied in the same order: the descriptor becomes a copy of the
+// file (which is opened above MAX_REDIRECT_FD, out of the way of every descriptor a redirection can name), or of the descriptor
+// given with n>&m (which must be open by then), or is closed for n>&-
+// returns 0, or -1 (after saying why) if a file couldn't be opened, in which case nothing is left open
+int openRedirects(const stage_t *stage, spawn_dup_t **dups)
+{
+  // the flags every kind of file is opened with; the descriptor is only handed over to the child through dup2, so it must not
+  // leak into anything else we launch
+  static const int openFlags[] = {
+      [REDIRECT_IN] = O_RDONLY,
+      [REDIRECT_OUT] = O_WRONLY | O_CREAT | O_TRUNC,
+      [REDIRECT_APPEND] = O_WRONLY | O_CREAT | O_APPEND,
+      [REDIRECT_IN_OUT] = O_RDWR | O_CREAT,
+  };
+
+  *dups = NULL;
+  if (stage->num_redirects == 0)
+  {
+    return 0;
+  }
+  *dups = malloc(sizeof(spawn_dup_t) * stage->num_redirects);
+  assert(*dups != NULL);
+
+  // whether each descriptor is open in the stage once the redirections so far are applied (-1 while it is the shell's own)
+  int isOpen[MAX_REDIRECT_FD + 1];
+  memset(isOpen, -1, sizeof(isOpen));
+
+  for (int index = 0; index < stage->num_redirects; ++index)
   {
-    wait(&state_check);
+    const redirect_t *redirect = &stage->redirects[index];
+    spawn_dup_t *dup = &(*dups)[index];
+    dup->fd = redirect->fd;
+
+    if (redirect->type == REDIRECT_DUP)
+    {
+      dup->source = (strcmp(redirect->file, "-") == 0) ? -1 : redirect->file[0] - '0';
+      if (dup->source != -1 && !(isOpen[dup->source] == -1 ? isInherited(dup->source) : isOpen[dup->source]))
+      {
+        fprintf(stderr, "%d: Bad file descriptor\n", dup->source);
+        closeRedirects(stage, *dups, index);
+        *dups = NULL;
+        return -1;
+      }
+      isOpen[redirect->fd] = (dup->source != -1);
+      continue;
+    }
+
+    int fwd = open(redirect->file, openFlags[redirect->type] | O_CLOEXEC, 0644);
+    if (fwd != -1 && fwd <= MAX_REDIRECT_FD)
+    {
+      int moved = fcntl(fwd, F_DUPFD_CLOEXEC, MAX_REDIRECT_FD + 1);
+      close(fwd);
+      fwd = moved;
+    }
+    trace_event(TRACE_REDIRECT_OPEN, (char *const[]){(char *)redirect->file, NULL}, -1, fwd);
 
-    if (!(WIFEXITED(state_check) && WEXITSTATUS(state_check) == 0))
+    if (fwd == -1)
     {
-      printf("Error performing redirection.\n");
+      perror(redirect->file);
+      closeRedirects(stage, *dups, index);
+      *dups = NULL;
       return -1;
     }
+    dup->source = fwd;
+    isOpen[redirect->fd] = 1;
   }
-
   return 0;
 }
 
-// determines whether command is a pipe
-int isPipe(const char *const *tokens)
+// to execute a command (a single stage) which includes redirection, measuring what it used up into usage (unless it is NULL)
+// returns the exit status of the command (1 if its files couldn't be opened, 127 if it couldn't be started), with *leave set
+// if it was a builtin leaving the shell (exit)
+int execRedirect(const stage_t *stage, run_usage_t *usage, int *leave)
 {
-  int index = 0;
-  while (tokens[index] != NULL)
+  spawn_dup_t *dups; // what the redirections do to the descriptors of the command
+  int state_check;
+
+  *leave = 0;
+  if (openRedirects(stage, &dups) == -1)
+  {
+    return 1;
+  }
+
+  // a builtin writes straight into (or reads straight from) the file, without a process of its own
+  const builtin_t *builtin = findStageBuiltin(stage->argv);
+  if (builtin != NULL)
   {
-    if (strcmp(tokens[index], "|") == 0)
+    int result = runRedirectedBuiltin(builtin, stage->argv, dups, stage->num_redirects, usage);
+    closeRedirects(stage, dups, stage->num_redirects);
+    if (builtin->utility)
     {
-      return 0;
+      return builtinStatus(result);
     }
-    index++;
+    *leave = (result == 1);
+    return 0;
+  }
+
+  // every redirection is applied by the child itself, with dup2, on its way to exec
+  spawn_request_t request = {
+      .argv = stage->argv,
+      .in_fd = 0,
+      .out_fd = 1,
+      .close_fd = -1,
+      .dups = dups,
+      .num_dups = stage->num_redirects,
+  };
+
+  uint64_t start = stats_now();
+  pid_t pid = spawn_process(&request);
+  closeRedirects(stage, dups, stage->num_redirects);
+
+  if (pid == -1)
+  {
+    printf("%s: command not found\n", stage->argv[0]);
+    return 127;
   }
-  return -1;
+
+  waitForeground(pid, &state_check, start, usage);
+  return exitStatus(state_check);
+}
+
+// Runs the commands of a group ( ... ) in the subshell forked for it (as the child function of its spawn request, with argv being
+// the tokens inside the parentheses, found again in launchingGroup), so the whole group takes a single process, and its
+// redirections are set up once for all of its commands
+// returns the status of the last command, which the subshell exits with; exit inside the group only leaves the subshell
+int runGroup(char *const *argv)
+{
+  interactive = 0;
+  trace_detach(); // the subshell's copy of the trace holds what the shell recorded, which the shell writes out itself
+  manageShell((const char *const *)argv, launchingGroup->group_types);
+  return lastStatus;
 }
 
-// to get the number of commands to pipe in the case of piping
-int numOfPipeCmds(const char *const *tokens)
+// runs a group ( ... ) of commands (a whole pipeline on its own, along with its redirections) in a subshell, and waits for it
+// returns the exit status of the subshell
+int execGroup(const stage_t *stage, run_usage_t *usage)
 {
-  int index = 0; // to iterate over tokens
-  int num = 1;   // starting from 1 as we know that if there is piping, there is at least 1 command to pipe
-  // iterating over the tokens
-  while (tokens[index] != NULL)
+  spawn_dup_t *dups;
+  int status;
+
+  if (openRedirects(stage, &dups) == -1)
   {
-    if (strcmp(tokens[index], "|") == 0)
-    {
-      num++;
-    }
-    index++;
+    return 1;
+  }
+
+  spawn_request_t request = {
+      .argv = stage->argv,
+      .in_fd = 0,
+      .out_fd = 1,
+      .close_fd = -1,
+      .dups = dups,
+      .num_dups = stage->num_redirects,
+      .child_fn = runGroup,
+  };
+
+  launchingGroup = stage;
+  uint64_t start = stats_now();
+  pid_t pid = spawn_process(&request);
+  closeRedirects(stage, dups, stage->num_redirects);
+
+  if (pid == -1)
+  {
+    perror("Error starting subshell");
+    return 1;
+  }
+
+  waitForeground(pid, &status, start, usage);
+  return exitStatus(status);
+}
+
+// Runs the command of a substitution $( ... ) (argv[0]) in the subshell forked for it, whose stdout is the pipe the shell reads
+// the output from (a lone program is executed in place of the subshell, just like with -c)
+// returns the status of the last command, which the subshell exits with
+int substitutionShell(char *const *argv)
+{
+  interactive = 0;
+  trace_detach(); // the subshell's copy of the trace holds what the shell recorded, which the shell writes out itself
+  runCommandString(argv[0]);
+  return lastStatus;
+}
+
+// runs the command of a substitution in a subshell, and captures everything it writes to its stdout (see capture_fd)
+// returns the exit status of the subshell, or -1 if it couldn't be run or its output couldn't be read
+int runSubstitution(const char *cmd, capture_t *capture)
+{
+  int fds[2];
+  if (pipe(fds) == -1)
+  {
+    perror("Error creating pipe");
+    return -1;
+  }
+
+  char *argv[] = {(char *)cmd, NULL};
+  spawn_request_t request = {
+      .argv = argv,
+      .in_fd = 0,
+      .out_fd = fds[1],
+      .close_fd = fds[0],
+      .child_fn = substitutionShell,
+  };
+
+  uint64_t start = stats_now();
+  pid_t pid = spawn_process(&request);
+  close(fds[1]);
+  if (pid == -1)
+  {
+    perror("Error starting subshell");
+    close(fds[0]);
+    return -1;
+  }
+
+  // the output is read while the subshell is running, so that it never blocks on a full pipe
+  int captured = capture_fd(fds[0], capture);
+  if (captured == -1)
+  {
+    perror("Error reading the output of $( )");
+  }
+  close(fds[0]);
+
+  int status;
+  waitForeground(pid, &status, start, NULL);
+  if (captured == -1)
+  {
+    return -1;
   }
-  return num;
+  return exitStatus(status);
 }
 
 /*
- * Executes a single command by reading from the given input file descriptor and writing to the given output file descriptor.
- * The double char pointer command is passed to exec to execute the command.
+ * Launches a single stage of a pipeline, without waiting for it.
+ *
+ * The stage reads from inpFwd and writes to outFwd, unless it has redirections of its own, in which case the files are opened here
+ * and the child puts them in place of the corresponding ends of the pipe. closeFwd is the read end of the pipe the stage writes into, which the
+ * parent keeps open for the next stage; the child must not keep it open, so that the only descriptors left behind are its own stdin/stdout.
  *
- * If the function is executed in the child process, it sets up the ends of the pipe and sets them to either stdin for inpFwd or stdout for outFwd, depending on their given value.
- * It then executes the command using execvp. If the command execution fails, the child process exits with a status of 1.
+ * pgid is the process group to put the stage in (0 for a new one led by the stage, -1 to stay in the shell's).
  *
- * If the function is executed in the parent process, it waits for the child process to finish. If the child process exited with a non-zero status,
- * it prints an error message to the user regarding the given command and returns -1. Otherwise, it returns 0.
+ * Returns the pid of the child, or -1 if the stage could not be started, in which case its wait status is stored in status.
  */
-int pipeHelper(int inpFwd, int outFwd, const char *const *cmd)
+pid_t pipeHelper(int inpFwd, int outFwd, int closeFwd, const stage_t *stage, int *status, pid_t pgid)
 {
+  spawn_dup_t *dups; // what the stage's own redirections do to its descriptors, if it has any
 
-  // We Fork TO COPY THE CONTENTS HER
-  pid_t pid;
-  pid = fork();
-
-  int state_check;
-  int check = isRedirect(cmd);
+  if (openRedirects(stage, &dups) == -1)
+  {
+    *status = W_EXITCODE(1, 0);
+    return -1;
+  }
 
-  // If the current process is a child process (i.e., pid == 0), handle any input or output redirection if necessary.
-  //  If there is input redirection, set standard input to the input file descriptor (inpFwd) and close the original input file descriptor.
-  //  If there is output redirection, set standard output to the output file descriptor (outFwd) and close the original output file descriptor.
-  //  If there is no redirection, execute the command using execvp. If execvp fails, exit the child process with an error code.
-  //  Returns: void
-  if (pid == 0)
+  spawn_request_t request = {
+      .argv = stage->argv,
+      .in_fd = inpFwd,
+      .out_fd = outFwd,
+      .close_fd = closeFwd,
+      .dups = dups,
+      .num_dups = stage->num_redirects,
+      .set_pgid = (pgid != -1),
+      .pgid = (pgid != -1) ? pgid : 0,
+      .child_fn = (stage->group_types != NULL) ? runGroup : childBuiltin(stage->argv),
+  };
+
+  launchingGroup = stage;
+  pid_t pid = spawn_process(&request);
+  closeRedirects(stage, dups, stage->num_redirects);
+
+  if (pid == -1)
   {
-    if (inpFwd != 0)
-    {
-      close(0);
-      assert(dup(inpFwd) == 0);
-      close(inpFwd);
-    }
+    *status = W_EXITCODE(127, 0);
+  }
 
-    if (outFwd != 1)
-    {
-      close(1);
-      assert(dup(outFwd) == 1);
-      close(outFwd);
-    }
+  return pid;
+}
 
-    // for input redirection
-    if (check == 0)
-    {
-      if (execRedirect(cmd, inpFwd) != 0)
-      {
-        exit(1);
-      }
-      else
-      {
-        exit(0);
-      }
-    }
+/*
+ * Reports the exit status of every stage of a pipeline which did not succeed (pids holds -1 for a stage which couldn't be started).
+ * A stage killed by SIGPIPE is not reported, as that is the normal way for a writer to stop once its reader is done (e.g. `yes | head`).
+ */
+void reportPipeStatus(char *const *stageNames, const pid_t *pids, const int *statuses, int num)
+{
+  for (int index = 0; index < num; ++index)
+  {
+    int status = statuses[index];
 
-    // for output redirection
-    else if (check == 1)
+    if (pids[index] == -1 && WIFEXITED(status) && WEXITSTATUS(status) == 127)
     {
-      if (execRedirect(cmd, outFwd) != 0)
-      {
-        exit(1);
-      }
-      else
-      {
-        exit(0);
-      }
+      printf("%s: command not found\n", stageNames[index]);
     }
-
-    // for no redirection
-    else if (check == -1 && execvp(cmd[0], cmd) == -1)
+    else if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
     {
-      exit(1);
+      printf("%s: exited with status %d (stage %d)\n", stageNames[index], WEXITSTATUS(status), index + 1);
     }
-  }
-
-  //  If the current process is the parent process, wait for the child process to finish and check its exit status.
-  //  If the child process exited successfully, return 0.
-  //  If the child process did not exit successfully, print an error message indicating that the command was not found and return -1.
-  //  Returns: 0 if the child process exited successfully, -1 if the child process did not exit successfully.
-  else
-  {
-    wait(&state_check);
-    if (!(WIFEXITED(state_check) && WEXITSTATUS(state_check) == 0))
+    else if (WIFSIGNALED(status) && WTERMSIG(status) != SIGPIPE)
     {
-      printf("%s: command not found\n", cmd[0]);
-      return -1;
+      printf("%s: terminated by signal %d (stage %d)\n", stageNames[index], WTERMSIG(status), index + 1);
     }
-    return 0;
   }
 }
 
 /*
-Function will execute the given tokens which contain a pipe symbol
-Get the number of commands seperated by the pipes, for each of those minus the last one,
-parse the current command, create a new pipe, call executePipeHelper with the previous pipe's input file descriptor
-And, the current pipe's output file descriptor and the currentcommand.
-close the current pipe's ouput file descriptor, and set inpFwd to the current pipe's input fd, AND KEEP LOOPING.
-If the last cmd contains a redirection symbol, call executeRedirection with either input or output fd of the current pipe, depending on the rediretion symbol. If it doesn't, then execute it with executeCommand.
-Returns 0 if success, -1 if fails
+Launches every stage of the given pipeline, without waiting for any of them.
+All the stages are launched up front, so that they run concurrently: for each stage but the last one, a new pipe is created and
+the stage is launched with the previous pipe's read end as its stdin and the current pipe's write end as its stdout. The parent closes
+both of those right after the launch, so it never holds more than a single read end, and every reader sees EOF as soon as its writer exits.
+The pid, status (for a stage which couldn't be started) and program of each stage go into pids, statuses and stageNames, which must have
+room for every stage of the pipeline, and the number of stages launched goes into launched.
+A pipeline run in the background gets a process group of its own (led by its first stage), and reads from /dev/null unless the shell
+reads its commands from a terminal, so that it can't take any of them away from the shell.
+Returns 0 if every stage could be set up, -1 otherwise.
 */
-int execPipe(const char const *const *tokens)
+int launchPipe(const pipeline_t *pipeline, pid_t *pids, int *statuses, char **stageNames, int *launched, int background)
 {
   int inpFwd = 0;
   int pipe_Fwd[2];
   int index;
-  int tokens_iter = 0; // for iterating over tokens
-  int state_check;
-  int redirection;
-
-  int num = numOfPipeCmds(tokens);
-  char *currCmd[20];
-
-  pid_t pid;
-  pid = fork();
-
-  /*
-   * This block of code executes multiple piped commands by forking a child process for each command and setting up
-   * the pipes between them. The tokens are parsed and stored in currCmd, and the PipeHelper function is called to
-   * execute each command with the appropriate input and output file descriptors.
-   * For each command, a new pipe is created using pipe and the appropriate input file descriptor is passed to the
-   * PipeHelper function. If PipeHelper returns -1, the child process exits with a status of 1.
-   * Once all commands have been executed, the child process checks for any output redirection and executes the final
-   * command using either the execCmd or Redirection function depending on the presence of output redirection.
-   * Finally, the child process closes the pipes and exits with a status of 0.
-   */
-  if (pid == 0)
-  {
-    for (index = 0; index < num - 1; ++index)
-    {
-      // iterate over each token and store/execute it sequentially
-      int i = 0;
-      while (tokens[tokens_iter] != NULL && strcmp(tokens[tokens_iter], "|") != 0)
-      { // "ls", "-F" |
-        currCmd[i] = tokens[tokens_iter];
-        i++;
-        tokens_iter++;
-      }
-      tokens_iter++;     // inc the count1 to skip over the | in the next iter
-      currCmd[i] = NULL; // set the last elt to NULL; this is for execv's sanity
-      pipe(pipe_Fwd);
-
-      if (pipeHelper(inpFwd, pipe_Fwd[1], currCmd) == -1)
-      { // ls | nl -> currentCmd {ls ... NULL}
-        close(pipe_Fwd[1]);
-        exit(1);
-      }
+  int result = 0;
+  pid_t pgid = background ? 0 : -1; // the process group of the stages (led by the first one, in the background)
 
-      close(pipe_Fwd[1]);
-      inpFwd = pipe_Fwd[0];
-    }
+  int num = pipeline->num_stages;
+  *launched = 0;
 
-    if (inpFwd != 0)
+  if (background && !isatty(0))
+  {
+    inpFwd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if (inpFwd == -1)
     {
-      close(0);
-      assert(dup(inpFwd) == 0);
+      inpFwd = 0;
     }
+  }
+
+  for (index = 0; index < num; ++index)
+  {
+    const stage_t *stage = &pipeline->stages[index];
+    int outFwd = 1;
+    int closeFwd = -1;
 
-    if (pipe_Fwd[1] == 1)
+    // every stage but the last writes into a new pipe
+    if (index < num - 1)
     {
-      close(pipe_Fwd[1]);
+      if (pipe(pipe_Fwd) == -1)
+      {
+        perror("Error creating pipe");
+        result = -1;
+        break;
+      }
+      trace_event(TRACE_PIPE_CREATE, NULL, pipe_Fwd[1], pipe_Fwd[0]);
+      outFwd = pipe_Fwd[1];
+      closeFwd = pipe_Fwd[0];
     }
 
-    int i = 0;
+    pids[index] = pipeHelper(inpFwd, outFwd, closeFwd, stage, &statuses[index], pgid);
+    stageNames[index] = stage->argv[0];
 
-    while (tokens[tokens_iter] != NULL)
+    // the rest of the pipeline joins the group of the first stage which could be started
+    if (pgid == 0 && pids[index] != -1)
     {
-      currCmd[i] = tokens[tokens_iter];
-      i++;
-      tokens_iter++;
+      pgid = pids[index];
     }
 
-    currCmd[i] = NULL;
-    redirection = isRedirect(currCmd);
-    if (redirection == -1)
+    // the parent has no use for the ends handed over to the stage
+    if (inpFwd != 0)
     {
-      execCmd(currCmd);
+      close(inpFwd);
     }
-    else
+    if (outFwd != 1)
     {
-      execRedirect(currCmd, redirection);
+      close(outFwd);
     }
+    inpFwd = (closeFwd != -1) ? closeFwd : 0;
 
-    close(pipe_Fwd[0]);
-    close(inpFwd);
-    exit(0);
+    // a stage which could not be started still lets the rest of the pipeline run, just like in any other shell
+    (*launched)++;
   }
 
-  /* This code block is executed when the process is the parent process,
-   i.e., when pid != 0. Here, the parent process waits for the child process
-    to finish its execution using the wait() function. If the child process
-    has exited with a status other than 0, an error message is printed to
-    the console informing the user that an error has occurred while
-    performing the redirection. If the child process has executed
-    successfully, this code block returns 0 to the calling function,
-    indicating that the redirection was performed without any errors. */
-  else
+  // if we stopped early, the read end of the last pipe is still ours to close
+  if (inpFwd != 0)
   {
-    wait(&state_check);
-    if (!(WIFEXITED(state_check) && WEXITSTATUS(state_check) == 0))
-    {
-      printf("Error performing redirection!\n");
-      return -1;
-    }
-    return 0;
+    close(inpFwd);
   }
+
+  return result;
 }
 
-// to execute the command entered on the shell
-int execCmd(const char *const *tokens)
+/*
+Function will execute the given pipeline (of more than one stage).
+Every stage is launched by launchPipe, then the shell reaps all of them with wait4 and reports the status of the failed stages.
+Unless usages is NULL, what every stage used up goes into it (its real time running until the stage was reaped, as the stages
+are reaped in order).
+Returns the exit status of the last stage (1 if the pipeline couldn't be set up).
+*/
+int execPipe(const pipeline_t *pipeline, run_usage_t *usages)
 {
-  pid_t pid;
-  pid = fork();
-  int status;
-  int exitStatus;
+  int index;
+  int launched; // number of stages set up
 
-  if (pid == 0)
-  {
-    exitStatus = execvp(tokens[0], tokens);
-    if (exitStatus != NULL)
-    {
-      exit(1);
-    }
-  }
-  else
+  int num = pipeline->num_stages;
+  pid_t *pids = malloc(sizeof(pid_t) * num);     // the pid of each stage, in order
+  int *statuses = malloc(sizeof(int) * num);     // the wait status of each stage, in order
+  char **stageNames = malloc(sizeof(char *) * num); // the program run by each stage, for reporting
+  assert(pids != NULL && statuses != NULL && stageNames != NULL);
+
+  uint64_t start = stats_now();
+  int result = launchPipe(pipeline, pids, statuses, stageNames, &launched, 0);
+
+  // reap every stage that was launched, in order
+  for (index = 0; index < launched; ++index)
   {
-    wait(&status);
-    if (!(WIFEXITED(status) && WEXITSTATUS(status) == 0))
+    if (pids[index] != -1 && waitForeground(pids[index], &statuses[index], start, usages ? &usages[index] : NULL) == -1)
     {
-      printf("%s: command not found\n", tokens[0]);
-      return 1;
+      statuses[index] = 0;
     }
   }
 
-  return 0;
+  reportPipeStatus(stageNames, pids, statuses, launched);
+
+  int status = (result == 0) ? exitStatus(statuses[num - 1]) : 1;
+  free(pids);
+  free(statuses);
+  free(stageNames);
+  return status;
 }
 
-// Reads from the file specified by a path, if it is valid.
-// Terminates if one of the commands was exit or `CTRL + D`
-int execSource(const char *path)
+// to run the given pipeline (with or without pipes and redirections) in the background as a new job
+int execBackground(const pipeline_t *pipeline)
 {
-  FILE *file;
-  file = fopen(path, "r"); // open the file at the specified path, with read permission
+  int launched; // number of stages set up
 
-  // if the file was opened successfully
-  if (file != NULL)
-  {
-    char input[LINE_LENGTH];
-    char string[LINE_LENGTH] = "source ";
+  int num = pipeline->num_stages;
+  pid_t *pids = malloc(sizeof(pid_t) * num);
+  int *statuses = malloc(sizeof(int) * num);
+  char **stageNames = malloc(sizeof(char *) * num);
+  assert(pids != NULL && statuses != NULL && stageNames != NULL);
 
-    strcat(string, path); // appends the input from the file to the string[] array
+  int result = launchPipe(pipeline, pids, statuses, stageNames, &launched, 1);
 
-    // as long as some input is coming from the opened file into the input stream
-    while (fgets(input, LINE_LENGTH, file))
+  if (launched > 0)
+  {
+    // the job is listed with its tokens joined back together
+    size_t textLen = 0;
+    for (int index = 0; index < pipeline->num_tokens; ++index)
     {
-      // if the string and input from file are the same, exit function
-      // an infinite loop is possible in this case as our source command would run the same source command from the file which would again call the same source command from the same file, and so on...
-      if (strncmp(string, input, strlen(string)) == 0)
-      {
-        printf("Error: cannot call same command (Infinite Loop Possible).\n");
-        return 0;
-      }
-      if (sepCommmand(input) == 1)
+      textLen += strlen(pipeline->tokens[index]) + 1;
+    }
+    char *text = malloc(textLen + 1);
+    assert(text != NULL);
+    text[0] = '\0';
+    for (int index = 0; index < pipeline->num_tokens; ++index)
+    {
+      if (index > 0)
       {
-        return 1;
+        strcat(text, " ");
       }
+      strcat(text, pipeline->tokens[index]);
     }
-    return 0;
-  }
-  // if the file couldn't be opened successfully
-  else
-  {
-    printf("Invalid file path.\n");
-    return -1;
+
+    job_add(pids, statuses, launched, text);
+    free(text);
   }
+
+  free(pids);
+  free(statuses);
+  free(stageNames);
+  return result;
 }
 
-// To basically manage the shell and run the relevant functions for the each entered command
-int manageShell(const char *const *tokens, char *cmd)
+// parses the job given to fg, bg or wait (%n or n); 0 stands for the most recent job
+// returns NULL (after saying so) if there is no such job
+job_t *findJob(const char *builtin, const char *spec)
 {
-  int type = isRedirect(tokens); //  to check if there is any redirection or not
-
-  // if the command entered is 'exit'
-  if (isExit(tokens[0]) == 0)
-  {
-    free_tokens(tokens);
-    return 1;
-  }
-  // if the command entered is a pipe
-  else if (isPipe(tokens) == 0)
-  {
-    execPipe(tokens);
-  }
-  // if the command entered is a redirection
-  else if (type != -1)
-  {
-    execRedirect(tokens, type);
-  }
-  // if the command entered is 'source'
-  else if (strcmp("source", tokens[0]) == 0)
+  int id = 0;
+  if (spec != NULL)
   {
-    if (execSource(tokens[1]) == 1)
+    id = atoi(spec[0] == '%' ? spec + 1 : spec);
+    if (id <= 0)
     {
-      free_tokens(tokens);
-      return 1;
+      printf("%s: %s: no such job\n", builtin, spec);
+      return NULL;
     }
   }
-  // if the command entered is 'prev'
-  else if (isPrev(tokens[0]) == 0)
+
+  job_t *job = job_find(id);
+  if (job == NULL)
   {
-    execPrev(cachedPrevCmd);
+    printf("%s: %s: no such job\n", builtin, spec != NULL ? spec : "current");
   }
-  // if the command entered is 'cd'
-  else if (strcmp("cd", tokens[0]) == 0)
+  return job;
+}
+
+// to wait for the given job, or for every job, when "wait" is entered on the shell
+void execWait(const char *spec)
+{
+  if (spec != NULL)
   {
-    if (isCd(tokens[1]) == -1)
+    job_t *job = findJob("wait", spec);
+    if (job != NULL)
     {
-      printf("Error changing directory: please enter a valid path.\n");
+      job_wait(job, 0);
     }
+    return;
   }
-  // if the command entered is 'help'
-  else if (isHelp(tokens[0]) == 0)
+
+  job_t *job;
+  while ((job = job_find(0)) != NULL)
+  {
+    job_wait(job, 0);
+  }
+}
+
+// to execute the command entered on the shell, measuring what it used up into usage (unless it is NULL)
+// a utility builtin (such as echo) is run by the shell itself, without launching anything
+// returns the exit status of the command (127 if it couldn't be started)
+int execCmd(const char *const *tokens, run_usage_t *usage)
+{
+  int status;
+
+  const builtin_t *builtin = findStageBuiltin((char *const *)tokens);
+  if (builtin != NULL && builtin->utility)
+  {
+    return builtinStatus(runBuiltin(builtin, (char *const *)tokens, usage));
+  }
+
+  spawn_request_t request = {
+      .argv = (char *const *)tokens,
+      .in_fd = 0,
+      .out_fd = 1,
+      .close_fd = -1,
+  };
+
+  uint64_t start = stats_now();
+  pid_t pid = spawn_process(&request);
+
+  if (pid == -1)
+  {
+    printf("%s: command not found\n", tokens[0]);
+    return 127;
+  }
+
+  waitForeground(pid, &status, start, usage);
+  return exitStatus(status);
+}
+
+// checks whether a line of a script sources the script itself (at path), which would never end
+int isSelfSource(const char *line, const char *path, size_t pathLen)
+{
+  return strncmp(line, "source ", 7) == 0 && strncmp(line + 7, path, pathLen) == 0;
+}
+
+// Runs every command of a script which has already been parsed (read from path, or NULL for an entry of the history)
+// Terminates if one of the commands was exit
+int runScript(const script_t *script, const char *path)
+{
+  size_t pathLen = (path != NULL) ? strlen(path) : 0;
+
+  for (size_t index = 0; index < script->num_commands; ++index)
+  {
+    const script_command_t *command = &script->commands[index];
+
+    // the check is done once per line, before any of its commands run
+    if (path != NULL && command->first_of_line && isSelfSource(command->text, path, pathLen))
+    {
+      printf("Error: cannot call same command (Infinite Loop Possible).\n");
+      return 0;
+    }
+
+    if (manageShell((const char *const *)command->tokens, command->types) == 1)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Runs a script straight out of its file (of size bytes) mapped into memory, one line at a time
+// Lines are found with memchr and tokenized where they are, without being copied anywhere first.
+// The commands may shrink the file while it runs, and touching the mapping past the end of the file would kill the shell,
+// so the size is looked at again before every line (and the script ends where the file now does).
+// Terminates if one of the commands was exit
+int runMappedScript(int fd, const char *text, size_t size, const char *path)
+{
+  size_t pathLen = strlen(path);
+  size_t lineStart = 0;
+
+  // the script ends at its first \0, just like a line read by getline would
+  const char *nul = memchr(text, '\0', size);
+  if (nul != NULL)
+  {
+    size = nul - text;
+  }
+
+  while (lineStart < size)
+  {
+    struct stat info;
+    if (fstat(fd, &info) == -1 || (size_t)info.st_size <= lineStart)
+    {
+      break;
+    }
+    size_t end = ((size_t)info.st_size < size) ? (size_t)info.st_size : size;
+
+    const char *line = &text[lineStart];
+    const char *newline = memchr(line, '\n', end - lineStart);
+    size_t lineLen = (newline != NULL) ? (size_t)(newline - line) + 1 : end - lineStart;
+    lineStart += lineLen;
+
+    // the line isn't followed by a \0, so it is only checked if it is long enough to hold the whole source command
+    if (lineLen >= 7 + pathLen && isSelfSource(line, path, pathLen))
+    {
+      printf("Error: cannot call same command (Infinite Loop Possible).\n");
+      return 0;
+    }
+    if (sepCommmand(line, lineLen) == 1)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Reads from the file specified by a path, if it is valid.
+// Terminates if one of the commands was exit or `CTRL + D`
+// A regular file (of up to 1 MB) is mapped into memory and parsed in one go, and kept in the script cache, so sourcing it again
+// (as long as it hasn't changed) runs the commands straight away. A larger one is mapped into memory and run as it is read,
+// and anything else (a pipe, a FIFO, ...) is read line by line with getline, so lines can be of any length.
+int execSource(const char *path)
+{
+  int fd = open(path, O_RDONLY | O_CLOEXEC); // open the file at the specified path, with read permission
+  struct stat info;
+
+  if (fd != -1 && fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+  {
+    script_t *script = script_load(fd, &info);
+    if (script != NULL)
+    {
+      close(fd);
+      int result = runScript(script, path);
+      script_release(script);
+      return result;
+    }
+
+    void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED)
+    {
+      madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+      int result = runMappedScript(fd, mapping, info.st_size, path);
+      munmap(mapping, info.st_size);
+      close(fd);
+      return result;
+    }
+  }
+
+  FILE *file = (fd != -1) ? fdopen(fd, "r") : NULL;
+
+  // if the file was opened successfully
+  if (file != NULL)
   {
-    // do nothing, just display the help menu.
+    char *input = NULL;   // the current line, grown by getline as needed
+    size_t capacity = 0;  // how much room there is in input
+    ssize_t len;
+    size_t pathLen = strlen(path);
+    int result = 0;
+
+    // as long as some input is coming from the opened file into the input stream
+    while ((len = getline(&input, &capacity, file)) != -1)
+    {
+      // if the line is the same source command as the one we are running, exit function
+      // an infinite loop is possible in this case as our source command would run the same source command from the file which would again call the same source command from the same file, and so on...
+      if (isSelfSource(input, path, pathLen))
+      {
+        printf("Error: cannot call same command (Infinite Loop Possible).\n");
+        break;
+      }
+      if (sepCommmand(input, len) == 1)
+      {
+        result = 1;
+        break;
+      }
+    }
+
+    free(input);
+    fclose(file);
+    return result;
   }
+  // if the file couldn't be opened successfully
   else
   {
-    if (strstr(cmd, "\n") != NULL)
+    printf("Invalid file path.\n");
+    return -1;
+  }
+}
+
+// changes the current working directory when "cd" is entered on the shell
+int builtinCd(char *const *argv)
+{
+  if (argv[1] == NULL || isCd(argv[1]) == -1)
+  {
+    printf("Error changing directory: please enter a valid path.\n");
+  }
+  return 0;
+}
+
+// runs a script when "source" is entered on the shell
+int builtinSource(char *const *argv)
+{
+  if (argv[1] == NULL)
+  {
+    printf("Invalid file path.\n");
+    return 0;
+  }
+  return execSource(argv[1]) == 1 ? 1 : 0;
+}
+
+// to list, clear or pre-warm the table of command paths when "hash" is entered on the shell
+int builtinHash(char *const *argv)
+{
+  execHash((const char *const *)argv);
+  return 0;
+}
+
+// to show or select the spawn backend when "spawn" is entered on the shell
+int builtinSpawn(char *const *argv)
+{
+  execSpawn(argv[1]);
+  return 0;
+}
+
+// to list the jobs when "jobs" is entered on the shell
+int builtinJobs(char *const *argv)
+{
+  (void)argv;
+  jobs_print();
+  return 0;
+}
+
+// to wait for jobs when "wait" is entered on the shell
+int builtinWait(char *const *argv)
+{
+  execWait(argv[1]);
+  return 0;
+}
+
+// to continue a job in the foreground or in the background when "fg" or "bg" is entered on the shell
+int builtinContinue(char *const *argv)
+{
+  job_t *job = findJob(argv[0], argv[1]);
+  if (job != NULL)
+  {
+    job_continue(job, argv[0][0] == 'f');
+  }
+  return 0;
+}
+
+// to show or reset the timings of the parts of running commands when "stats" is entered on the shell
+int builtinStats(char *const *argv)
+{
+  if (argv[1] != NULL && strcmp(argv[1], "-r") == 0)
+  {
+    stats_reset();
+  }
+  else if (stats_print(argv[1]) == -1)
+  {
+    printf("stats: unknown kind '%s' (expected tokenize, parse, lookup, spawn, wait or command).\n", argv[1]);
+  }
+  return 0;
+}
+
+// works out the key the output of a command is cached under (for cached): where it is run, its words, the program they name and
+// every input file handed to it (with what it holds when hashContents is set), into *key
+// returns 1, or 0 if the command can't be cached, its stdin being a pipe (or anything else which isn't a file) given to it alone
+int cachedKey(char *const *argv, int hashContents, result_key_t *key)
+{
+  result_key_init(key);
+
+  char cwd[PATH_MAX];
+  result_key_add(key, cwd, (getcwd(cwd, sizeof(cwd)) != NULL) ? strlen(cwd) : 0);
+  for (int index = 0; argv[index] != NULL; ++index)
+  {
+    result_key_add(key, argv[index], strlen(argv[index]) + 1);
+  }
+  const char *program = (findBuiltin(argv[0]) != NULL) ? "" : path_lookup(argv[0]);
+  result_key_add(key, program, (program != NULL) ? strlen(program) : 0);
+
+  for (int fd = 0; fd <= MAX_REDIRECT_FD; ++fd)
+  {
+    struct stat info;
+    if (fd == 1 || fd == 2 || !isInherited(fd) || (fcntl(fd, F_GETFL) & O_ACCMODE) == O_WRONLY || fstat(fd, &info) == -1)
+    {
+      continue;
+    }
+    if (fd == 0 && info.st_dev == shellInput.st_dev && info.st_ino == shellInput.st_ino)
+    {
+      continue; // the shell's own stdin, which the command doesn't get
+    }
+    if (S_ISREG(info.st_mode))
     {
-      cmd[strlen(cmd) - 1] = '\0';
+      result_key_add_file(key, fd, hashContents);
     }
-    // if the command has been executed, update prevCmd with it
-    if (execCmd(tokens) == 0)
+    else if (fd == 0)
     {
-      strcpy(cachedPrevCmd, cmd);
+      return 0;
     }
   }
+  return 1;
+}
+
+// runs a command through the cache of results when "cached" is entered on the shell, or for a command named in
+// MINISHELL_CACHE_COMMANDS: its output and exit status are replayed from the cache when it has been run on the same input before,
+// without launching anything; otherwise it is run with its output going both to stdout and into the cache
+// (the command never reads the shell's own stdin, which it gets /dev/null in place of)
+// returns the exit status of the command
+int builtinCached(char *const *argv)
+{
+  int hashContents = 0;
+  if (strcmp(argv[0], "cached") == 0)
+  {
+    hashContents = (argv[1] != NULL && strcmp(argv[1], "-h") == 0);
+    argv += 1 + hashContents;
+    if (argv[0] == NULL)
+    {
+      printf("cached: usage: cached [-h] cmd [args ..]\n");
+      return 1;
+    }
+  }
+
+  const builtin_t *builtin = findBuiltin(argv[0]);
+  if (builtin != NULL && !builtin->utility)
+  {
+    printf("cached: %s: only commands run for their output can be cached\n", argv[0]);
+    return 1;
+  }
+
+  fflush(stdout);
+  result_key_t key;
+  int cacheable = cachedKey(argv, hashContents, &key);
+  int status;
+  int stored = cacheable ? result_lookup(&key, &status) : -1;
+  if (stored != -1)
+  {
+    copy_fd(stored, 1);
+    close(stored);
+    return status;
+  }
+  if (!cacheable)
+  {
+    result_cache_uncacheable();
+  }
+
+  int fds[2];
+  if (pipe(fds) == -1)
+  {
+    perror("Error creating pipe");
+    return 1;
+  }
+
+  struct stat input;
+  int devNull = -1;
+  if (fstat(0, &input) == 0 && input.st_dev == shellInput.st_dev && input.st_ino == shellInput.st_ino)
+  {
+    devNull = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  }
+  spawn_request_t request = {
+      .argv = argv,
+      .in_fd = (devNull != -1) ? devNull : 0,
+      .out_fd = fds[1],
+      .close_fd = fds[0],
+      .child_fn = (builtin != NULL) ? builtin->run : NULL,
+  };
+
+  uint64_t start = stats_now();
+  pid_t pid = spawn_process(&request);
+  close(fds[1]);
+  if (devNull != -1)
+  {
+    close(devNull);
+  }
+  if (pid == -1)
+  {
+    close(fds[0]);
+    printf("%s: command not found\n", argv[0]);
+    return 127;
+  }
+
+  result_writer_t writer;
+  int storing = cacheable && result_begin(&writer) == 0;
+  long long size = storing ? tee_fd(fds[0], 1, &writer.fd, 1) : copy_fd(fds[0], 1);
+  close(fds[0]);
+
+  waitForeground(pid, &status, start, NULL);
+  if (storing && size != -1 && WIFEXITED(status))
+  {
+    result_commit(&writer, &key, WEXITSTATUS(status), size);
+  }
+  else if (storing)
+  {
+    result_abort(&writer);
+  }
+  return exitStatus(status);
+}
+
+// to show what the cache of results holds, or to empty it, when "cache" is entered on the shell
+int builtinCache(char *const *argv)
+{
+  if (argv[1] == NULL || strcmp(argv[1], "stats") == 0)
+  {
+    result_cache_stats();
+  }
+  else if (strcmp(argv[1], "clear") == 0)
+  {
+    result_cache_clear();
+  }
+  else
+  {
+    printf("cache: unknown action '%s' (expected stats or clear).\n", argv[1]);
+  }
   return 0;
 }
 
+// every builtin, looked up by name before a program is launched for a command
+static const builtin_t builtins[] = {
+    {"exit", builtinExit, 0},
+    {"cd", builtinCd, 0},
+    {"source", builtinSource, 0},
+    {"prev", builtinPrev, 0},
+    {"history", builtinHistory, 1},
+    {"hash", builtinHash, 0},
+    {"spawn", builtinSpawn, 0},
+    {"jobs", builtinJobs, 0},
+    {"wait", builtinWait, 0},
+    {"fg", builtinContinue, 0},
+    {"bg", builtinContinue, 0},
+    {"stats", builtinStats, 0},
+    {"cache", builtinCache, 0},
+    {"cached", builtinCached, 1},
+    {"help", builtinHelp, 0},
+    {"echo", builtin_echo, 1},
+    {"true", builtin_true, 1},
+    {"false", builtin_false, 1},
+    {"test", builtin_test, 1},
+    {"[", builtin_test, 1},
+    {"printf", builtin_printf, 1},
+    {"pwd", builtin_pwd, 1},
+    {"tee", builtin_tee, 1},
+    {"parallel", parallel_main, 1},
+};
+
+#define NUM_BUILTINS (sizeof(builtins) / sizeof(builtins[0]))
+
+// the builtins again, each in the slot picked for its name by hashBuiltin with builtinSeed, which initBuiltins finds so that no two
+// of them share a slot: looking a name up then takes a single hash and a single strcmp
+static const builtin_t *builtinSlots[BUILTIN_SLOTS];
+static uint32_t builtinSeed;
+
+// hashing a name (FNV-1a, then mixed so that every bit of the seed reaches the low bits used for picking a slot)
+static uint32_t hashBuiltin(const char *name, uint32_t seed)
+{
+  uint32_t hash = 2166136261u ^ seed;
+  for (const unsigned char *cursor = (const unsigned char *)name; *cursor != '\0'; ++cursor)
+  {
+    hash = (hash ^ *cursor) * 16777619u;
+  }
+  hash ^= hash >> 16;
+  hash *= 0x7feb352du;
+  hash ^= hash >> 15;
+  return hash & (BUILTIN_SLOTS - 1);
+}
+
+// trying seeds until one puts every builtin in a slot of its own
+// with twice as many slots as builtins, a few dozen seeds are usually enough
+void initBuiltins()
+{
+  for (uint32_t seed = 0; seed < (1u << 20); ++seed)
+  {
+    memset(builtinSlots, 0, sizeof(builtinSlots));
+
+    size_t index;
+    for (index = 0; index < NUM_BUILTINS; ++index)
+    {
+      const builtin_t **slot = &builtinSlots[hashBuiltin(builtins[index].name, seed)];
+      if (*slot != NULL)
+      {
+        break;
+      }
+      *slot = &builtins[index];
+    }
+
+    if (index == NUM_BUILTINS)
+    {
+      builtinSeed = seed;
+      return;
+    }
+  }
+  assert(0 && "no seed gives every builtin a slot of its own");
+}
+
+// to find the builtin with the given name, or NULL if there is none
+const builtin_t *findBuiltin(const char *name)
+{
+  const builtin_t *builtin = builtinSlots[hashBuiltin(name, builtinSeed)];
+  return (builtin != NULL && strcmp(builtin->name, name) == 0) ? builtin : NULL;
+}
+
+// cat, when it is run without any option (just files, or -), which is all builtin_cat understands
+static const builtin_t plainCat = {"cat", builtin_cat, 1};
+
+// what runs the commands named in MINISHELL_CACHE_COMMANDS, through the cache of results
+static const builtin_t cachedCommand = {"cached", builtinCached, 1};
+
+// to find the builtin running a stage (argv being its program and arguments), or NULL if a program is launched for it
+// On top of the builtins themselves, a plain cat is run by the shell, which copies the files inside the kernel instead of going
+// through the buffers of a cat process (e.g. `cat in > out`, or `cat big | cmd`); cat with options is still the real one.
+const builtin_t *findStageBuiltin(char *const *argv)
+{
+  if (result_cache_wants(argv[0]))
+  {
+    return &cachedCommand;
+  }
+
+  const builtin_t *builtin = findBuiltin(argv[0]);
+  if (builtin != NULL || strcmp(argv[0], "cat") != 0)
+  {
+    return builtin;
+  }
+
+  for (int index = 1; argv[index] != NULL; ++index)
+  {
+    if (argv[index][0] == '-' && argv[index][1] != '\0')
+    {
+      return NULL;
+    }
+  }
+  return &plainCat;
+}
+
+// prints what a pipeline run with time (starting at start, from stats_now) used up: each of its stages (if there are several of
+// them), then the whole of it, the times of its stages added up and the peak memory of the largest one
+void reportTimes(const pipeline_t *pipeline, const run_usage_t *usages, uint64_t start)
+{
+  run_usage_t total = usages[0];
+
+  if (pipeline->num_stages > 1)
+  {
+    char label[64];
+    memset(&total, 0, sizeof(total));
+
+    for (int index = 0; index < pipeline->num_stages; ++index)
+    {
+      const run_usage_t *usage = &usages[index];
+      snprintf(label, sizeof(label), "stage %d (%s): ", index + 1, pipeline->stages[index].argv[0]);
+      usage_print(label, usage);
+
+      total.user_ns += usage->user_ns;
+      total.sys_ns += usage->sys_ns;
+      if (usage->max_rss_kb > total.max_rss_kb)
+      {
+        total.max_rss_kb = usage->max_rss_kb;
+      }
+    }
+  }
+
+  total.real_ns = stats_now() - start;
+  usage_print("", &total);
+}
+
+// runs a pipeline (parsed out of tokens, with types) holding substitutions $( ... ), which are only run once the pipelines before it
+// are done: in the foreground, the output of each of them takes its place (as words) and the pipeline is then run as a command of
+// its own; in the background, the whole pipeline goes to a subshell of its own, just like a group, which expands them there
+// returns 1 if the pipeline left the shell (exit), and 0 otherwise
+int runExpanded(const char *const *tokens, const unsigned char *types, const pipeline_t *pipeline)
+{
+  const unsigned char *ownTypes = &types[pipeline->tokens - (char *const *)tokens];
+  char **ownTokens = malloc((pipeline->num_tokens + 1) * sizeof(char *));
+  assert(ownTokens != NULL);
+  memcpy(ownTokens, pipeline->tokens, pipeline->num_tokens * sizeof(char *));
+  ownTokens[pipeline->num_tokens] = NULL;
+
+  int result = 0;
+  if (pipeline->background)
+  {
+    stage_t group = {.argv = ownTokens, .group_types = ownTypes};
+    pipeline_t job = *pipeline;
+    job.stages = &group;
+    job.num_stages = 1;
+    execBackground(&job);
+    lastStatus = 0;
+  }
+  else
+  {
+    expansion_t expansion;
+    if (expand_substitutions((const char *const *)ownTokens, ownTypes, runSubstitution, &expansion) == -1)
+    {
+      lastStatus = 1;
+    }
+    else
+    {
+      // (unless the substitutions were all there was to the pipeline, and they wrote nothing)
+      if (expansion.tokens[0] != NULL)
+      {
+        result = manageShell((const char *const *)expansion.tokens, expansion.types);
+      }
+      expansion_free(&expansion);
+    }
+  }
+
+  free(ownTokens);
+  return result;
+}
+
+// To basically manage the shell and run the relevant functions for the each entered command
+// the command is parsed once (with types[n] the type of tokens[n]), and every pipeline of it is run from its parsed form
+int manageShell(const char *const *tokens, const unsigned char *types)
+{
+  // a command starting with # is a comment (such as the #! line of a script run as shell script.sh)
+  if (types[0] == TOKEN_WORD && tokens[0][0] == '#')
+  {
+    return 0;
+  }
+
+  uint64_t start = stats_now();
+  trace_event(TRACE_COMMAND_BEGIN, (char *const *)tokens, -1, 0);
+  command_t command;
+  int parsed = parse_command((char *const *)tokens, types, &command);
+  stats_record(STAT_PARSE, start);
+  if (parsed == -1)
+  {
+    trace_event(TRACE_COMMAND_END, NULL, -1, 0);
+    return 0;
+  }
+
+  int result = 0;
+  for (int index = 0; index < command.num_pipelines && result == 0; ++index)
+  {
+    const pipeline_t *pipeline = &command.pipelines[index];
+    if (pipeline->substitutions)
+    {
+      result = runExpanded(tokens, types, pipeline);
+      continue;
+    }
+
+    const stage_t *stage = &pipeline->stages[0];
+    const builtin_t *builtin = findStageBuiltin(stage->argv);
+
+    // what every stage of a pipeline run with time used up (NULL when it isn't timed, so nothing is measured)
+    run_usage_t *usages = NULL;
+    uint64_t pipelineStart = stats_now();
+    if (pipeline->timed && !pipeline->background)
+    {
+      usages = calloc(pipeline->num_stages, sizeof(run_usage_t));
+      assert(usages != NULL);
+    }
+    if (!pipeline->background)
+    {
+      trace_event(TRACE_RUN_BEGIN, stage->argv, -1, 0);
+    }
+
+    // everything followed by & runs in the background
+    if (pipeline->background)
+    {
+      execBackground(pipeline);
+      lastStatus = 0;
+    }
+    // if the command entered is a pipe
+    else if (pipeline->num_stages > 1)
+    {
+      lastStatus = execPipe(pipeline, usages);
+    }
+    // if the command entered is a group of commands, run in a subshell
+    else if (stage->group_types != NULL)
+    {
+      lastStatus = execGroup(stage, usages);
+    }
+    // if the command entered is a redirection
+    else if (stage->num_redirects > 0)
+    {
+      int status = execRedirect(stage, usages, &result);
+      lastStatus = result ? lastStatus : status; // leaving the shell keeps the status it exits with
+    }
+    // if the command entered is a builtin changing the shell itself (exit, cd, source, ...)
+    else if (builtin != NULL && !builtin->utility)
+    {
+      result = runBuiltin(builtin, stage->argv, usages);
+      lastStatus = (result == 1) ? lastStatus : 0; // leaving the shell keeps the status it exits with
+    }
+    else
+    {
+      lastStatus = execCmd((const char *const *)stage->argv, usages);
+    }
+
+    if (!pipeline->background)
+    {
+      trace_event(TRACE_RUN_END, NULL, -1, 0);
+    }
+    if (usages != NULL)
+    {
+      reportTimes(pipeline, usages, pipelineStart);
+      free(usages);
+    }
+  }
+
+  free_command(&command);
+  stats_record(STAT_COMMAND, start);
+  trace_event(TRACE_COMMAND_END, NULL, -1, 0);
+  trace_flush(0); // a long script never gets back to the prompt, so the trace is written out as it goes
+  return result;
+}
+
 // If manageShell returns 1, then we return 1 in order to exit the program
-// Free the tokens at every iteration, and get the next command to be executed.
-int sepCommmand(char cmd[]) // Check here if error
+// Get the next command to be executed from the line (of len bytes), which is never modified.
+// All the commands of the line share a single tokenizer for their tokens, which is freed once the whole line is done.
+int sepCommmand(const char *line, size_t len)
 {
-  char *currentCmd;
+  size_t start = 0; // where the current command starts in the line
+  int result = 0;
 
-  // Convert input into different commands
-  // get the first command seperated by ;
-  currentCmd = strtok(cmd, ";");
+  tokenizer_t lineTokenizer; // the tokens of the command currently being run
+  tokenizer_init(&lineTokenizer);
+  trace_event(TRACE_LINE_BEGIN, NULL, -1, len);
 
   // Keeps looping till the end of commands:
-  // Get the tokens from the currentCmd, and call manageShell
-  while (currentCmd != NULL && currentCmd[0] != '\n')
+  // Get the tokens from the current command, and call manageShell
+  while (start < len)
   {
-    char **getTokens = create_tokens(currentCmd);
+    // Convert input into different commands, seperated by ;
+    size_t cmdLen = command_length(&line[start], len - start);
+
+    uint64_t tokenizeStart = stats_now();
+    trace_event(TRACE_TOKENIZE_BEGIN, NULL, -1, cmdLen);
+    char **getTokens = tokenize_into(&lineTokenizer, &line[start], cmdLen);
     assert(getTokens != NULL);
+    stats_record(STAT_TOKENIZE, tokenizeStart);
+    trace_event(TRACE_TOKENIZE_END, NULL, -1, lineTokenizer.arena.num_tokens);
 
     // If manageShell returns 1, then exit func
-    if (manageShell(getTokens, currentCmd) == 1)
+    // (a command made of nothing but spaces is skipped)
+    if (getTokens[0] != NULL &&
+        manageShell((const char *const *)getTokens, lineTokenizer.arena.types) == 1)
     {
-      return 1;
+      result = 1;
+      break;
+    }
+
+    start += cmdLen + 1; // skip over the ; as well
+  }
+
+  tokenizer_free(&lineTokenizer);
+  trace_event(TRACE_LINE_END, NULL, -1, 0);
+  return result;
+}
+
+// Runs the commands given with -c
+// A lone program (with no pipe, redirection, & or time, and not a builtin) is executed in place of the shell, as there is nothing
+// left for the shell to do once it ends, which saves a fork and a wait. Everything else (or a program which can't be executed)
+// is run as usual.
+int runCommandString(const char *cmd)
+{
+  size_t len = strlen(cmd);
+
+  // (the trace would be lost along with the shell)
+  // (a substitution has to be run by the shell first)
+  if (!trace_enabled() && command_length(cmd, len) == len && strstr(cmd, "$(") == NULL)
+  {
+    tokenizer_t tokenizer;
+    tokenizer_init(&tokenizer);
+    char **tokens = tokenize_into(&tokenizer, cmd, len);
+    assert(tokens != NULL);
+
+    command_t command;
+    if (tokens[0] != NULL && tokens[0][0] != '#')
+    {
+      if (parse_command(tokens, tokenizer.arena.types, &command) == -1)
+      {
+        tokenizer_free(&tokenizer);
+        return 0;
+      }
+
+      const pipeline_t *pipeline = &command.pipelines[0];
+      const stage_t *stage = &pipeline->stages[0];
+      if (command.num_pipelines == 1 && pipeline->num_stages == 1 && !pipeline->background && !pipeline->timed &&
+          stage->num_redirects == 0 && stage->group_types == NULL && findStageBuiltin(stage->argv) == NULL)
+      {
+        const char *path = (strchr(stage->argv[0], '/') != NULL) ? stage->argv[0] : path_lookup(stage->argv[0]);
+        if (path != NULL)
+        {
+          fflush(stdout);
+          execv(path, stage->argv);
+        }
+      }
+      free_command(&command);
     }
+    tokenizer_free(&tokenizer);
+  }
+
+  return sepCommmand(cmd, len);
+}
+
+// Runs the commands of a request in the server worker which took it (see server_run), whose stdin, stdout and stderr are now the
+// client's ones; the commands (which can span several lines) are parsed in one go, just like a script
+// returns the exit status of the last command
+int runRequest(const char *commands, size_t len)
+{
+  // nothing has been written to stdout yet, so it can still be buffered as suits the client's stdout
+  setvbuf(stdout, NULL, isatty(1) ? _IOLBF : _IOFBF, 1 << 16);
+
+  script_t *script = script_parse(commands, len);
+  runScript(script, NULL);
+  script_release(script);
+  fflush(stdout);
+  return lastStatus;
+}
+
+// Parses a script into the script cache without running it, and looks up the programs its commands start with, so that every
+// worker of the server starts out with both (see runServer)
+void warmScript(const char *path)
+{
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  struct stat info;
+  script_t *script = (fd != -1 && fstat(fd, &info) == 0) ? script_load(fd, &info) : NULL;
+  if (fd != -1)
+  {
+    close(fd);
+  }
+  if (script == NULL)
+  {
+    fprintf(stderr, "%s: cannot be cached\n", path);
+    return;
+  }
 
-    free_tokens(getTokens);
+  for (size_t index = 0; index < script->num_commands; ++index)
+  {
+    const script_command_t *command = &script->commands[index];
+    if (command->types[0] == TOKEN_WORD && findStageBuiltin(command->tokens) == NULL && strchr(command->tokens[0], '/') == NULL)
+    {
+      path_lookup(command->tokens[0]);
+    }
+  }
+  script_release(script);
+}
 
-    currentCmd = strtok(NULL, ";");
+// Runs the shell as a server: shell --server socket [script ..] serves the commands sent by tools/shell_client (see server_run)
+// Every worker is forked from this shell once it is warm: the scripts given are parsed into the script cache (so sourcing them
+// takes no parsing), and the programs they run are in the PATH cache.
+// returns 1 if the socket couldn't be set up (and doesn't return otherwise)
+int runServer(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    fprintf(stderr, "usage: %s --server socket [script ..]\n", argv[0]);
+    return 2;
   }
 
-  return 0;
+  for (int index = 3; index < argc; ++index)
+  {
+    warmScript(argv[index]);
+  }
+  trace_close(); // what was traced while warming up is written out, and the workers (which would all share it) trace nothing
+  return server_run(argv[2], runRequest) == -1 ? 1 : 0;
+}
+
+// Runs the shell as shell -c 'commands' [name [args ..]] or shell script [args ..]: without the banner or any prompt, and
+// exiting once the commands are done (the arguments are accepted so that the shell can stand in for sh, but nothing expands them)
+// returns the exit status of the shell
+int runNonInteractive(int argc, char **argv)
+{
+  interactive = 0;
+  if (strcmp(argv[1], "--server") == 0)
+  {
+    return runServer(argc, argv);
+  }
+
+  // nobody is waiting on each line, so the output goes out in large blocks
+  // (it is still flushed before every program is launched, so it never ends up after the output of one)
+  static char outputBuffer[1 << 16];
+  if (!isatty(1))
+  {
+    setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+  }
+
+  int status = 0;
+  if (strcmp(argv[1], "-c") == 0)
+  {
+    if (argc < 3)
+    {
+      fprintf(stderr, "usage: %s [-c command | script] [args ..]\n", argv[0]);
+      status = 2;
+    }
+    else
+    {
+      runCommandString(argv[2]);
+      status = lastStatus;
+    }
+  }
+  else if (execSource(argv[1]) == -1)
+  {
+    status = 127;
+  }
+  else
+  {
+    status = lastStatus;
+  }
+
+  fflush(stdout);
+  trace_close();
+  return status;
+}
+
+// Adds a line entered at the prompt (of len bytes) to the history, unless it is blank or prev (which never becomes the new command
+// line), and marks it as the line being run
+void recordLine(const char *line, size_t len)
+{
+  while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == ' ' || line[len - 1] == '\t'))
+  {
+    len--;
+  }
+  if (len == 0 || (len == 4 && strncmp(line, "prev", 4) == 0))
+  {
+    currentEntry = 0;
+    return;
+  }
+  history_add(line, len);
+  currentEntry = HISTORY_LAST;
+}
+
+// Runs a line entered at the prompt which refers to an entry of the history: !n (the entry numbered n), !-n (the n-th last one),
+// !! (the last one) or !prefix (the most recent one starting with prefix); the entry is added to the history again, as the
+// line entered
+// Terminates if one of the commands of the entry was exit
+int execHistoryReference(const char *line, size_t len)
+{
+  while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == ' ' || line[len - 1] == '\t'))
+  {
+    len--;
+  }
+
+  const char *ref = line + 1;
+  size_t refLen = len - 1;
+  size_t count = history_count();
+  size_t number = 0; // (there is no entry 0)
+
+  if (refLen == 1 && ref[0] == '!')
+  {
+    number = count;
+  }
+  else if (isdigit((unsigned char)ref[0]) || (ref[0] == '-' && isdigit((unsigned char)ref[1])))
+  {
+    char *end;
+    long offset = strtol(ref, &end, 10);
+    size_t back = (size_t)0 - (size_t)offset; // (for a negative offset)
+    if (end == ref + refLen)
+    {
+      number = (offset >= 0) ? (size_t)offset : (back <= count ? count + 1 - back : 0);
+    }
+  }
+  else
+  {
+    number = history_find_prefix(ref, refLen);
+  }
+
+  size_t entryLen;
+  const char *entry = history_get(number, &entryLen);
+  if (entry == NULL)
+  {
+    printf("%.*s: event not found\n", (int)len, line);
+    return 0;
+  }
+
+  history_add(entry, entryLen);
+  return execEntry(number);
 }
 
 // Main keeps running the shell until the user enters exit or cmd-d
 int main(int argc, char **argv)
 {
+  // the backend for launching programs can be picked before the shell starts, e.g. MINISHELL_SPAWN=fork ./shell
+  const char *backend = getenv("MINISHELL_SPAWN");
+  if (backend != NULL && spawn_backend_from_name(backend) != -1)
+  {
+    spawn_set_backend(spawn_backend_from_name(backend));
+  }
+
+  // sourced scripts are parsed only once, unless MINISHELL_SOURCE_CACHE=0
+  const char *sourceCache = getenv("MINISHELL_SOURCE_CACHE");
+  if (sourceCache != NULL && strcmp(sourceCache, "0") == 0)
+  {
+    script_cache_set_enabled(0);
+  }
+
+  // everything the shell does can be traced into a file, e.g. MINISHELL_TRACE=trace.jsonl ./shell
+  // (bench/trace2chrome.py turns it into a trace which can be opened in Perfetto)
+  const char *tracePath = getenv("MINISHELL_TRACE");
+  if (tracePath != NULL && tracePath[0] != '\0')
+  {
+    trace_open(tracePath);
+  }
+
+  // the lines entered at the prompt are kept in ~/.minishell_history, or in MINISHELL_HISTORY (in memory only when it is empty)
+  const char *historyPath = getenv("MINISHELL_HISTORY");
+  char defaultHistory[PATH_MAX];
+  if (historyPath == NULL && getenv("HOME") != NULL)
+  {
+    snprintf(defaultHistory, sizeof(defaultHistory), "%s/.minishell_history", getenv("HOME"));
+    historyPath = defaultHistory;
+  }
+  history_open((historyPath != NULL && historyPath[0] != '\0') ? historyPath : NULL);
+
+  // the results of cached commands are kept in ~/.cache/minishell, or in MINISHELL_CACHE_DIR, holding up to MINISHELL_CACHE_SIZE
+  // megabytes (256 by default); the commands named in MINISHELL_CACHE_COMMANDS are cached without being prefixed with cached
+  const char *cacheDir = getenv("MINISHELL_CACHE_DIR");
+  char defaultCache[PATH_MAX];
+  if (cacheDir == NULL && getenv("HOME") != NULL)
+  {
+    snprintf(defaultCache, sizeof(defaultCache), "%s/.cache/minishell", getenv("HOME"));
+    cacheDir = defaultCache;
+  }
+  const char *cacheSize = getenv("MINISHELL_CACHE_SIZE");
+  unsigned long long cacheLimit = (cacheSize != NULL) ? strtoull(cacheSize, NULL, 10) : 256;
+  result_cache_configure(cacheDir, cacheLimit << 20, getenv("MINISHELL_CACHE_COMMANDS"));
+  fstat(0, &shellInput);
+
+  // the commands running in the background are reaped as soon as they finish
+  jobs_init();
+  initBuiltins();
+
+  if (argc > 1)
+  {
+    return runNonInteractive(argc, argv);
+  }
+
+  char *input = NULL;  // the current line, grown by getline as needed
+  size_t capacity = 0; // how much room there is in input
+
   printf("Welcome to mini-shell.\n");
   // to keep the shell running (technically) forever
   while (1)
   {
-    char input[LINE_LENGTH];
+    jobs_notify();
     printf("shell $ ");
-    int result = fgets(input, LINE_LENGTH, stdin);
-    if (result == NULL)
+    // nothing is left unwritten while waiting for someone at a terminal, and a whole batch at a time otherwise
+    trace_flush(isatty(0));
+    ssize_t len = getline(&input, &capacity, stdin);
+    if (len == -1)
     {
       printf("\nBye bye.\n");
-      return 0;
+      break;
     }
+    trace_event(TRACE_LINE_READ, NULL, -1, len);
 
-    if (sepCommmand(input))
+    // a line such as !12 or !make runs an entry of the history again, and any other line is added to it
+    if (input[0] == '!' && !isspace((unsigned char)input[1]) && input[1] != '\0')
+    {
+      if (execHistoryReference(input, len))
+      {
+        break;
+      }
+      continue;
+    }
+    recordLine(input, len);
+
+    if (sepCommmand(input, len))
     {
       break;
     }
   }
 
+  free(input);
+  history_close();
+  trace_close();
   return 0;
 }
-
@@ -0,0 +1,284 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+// ************** Including the necessary header file **************
+
+#include "spawn.h"
+#include "pathcache.h"
+#include "stats.h"
+#include "trace.h"
+
+// ************** Define global variables **************
+
+extern char **environ; // the environment handed to every spawned program
+
+static spawn_backend_t current_backend = SPAWN_POSIX; // the backend used by spawn_process
+
+// ************** Declaring the necessary functions **************
+
+static pid_t spawn_fork(const spawn_request_t *request, const char *path);
+static pid_t spawn_posix(const spawn_request_t *request, const char *path);
+
+// ************** Defining the declared functions **************
+
+// selecting the backend used by spawn_process
+
+void spawn_set_backend(spawn_backend_t backend)
+{
+  current_backend = backend;
+}
+
+spawn_backend_t spawn_get_backend()
+{
+  return current_backend;
+}
+
+// converting between a backend and its name
+
+int spawn_backend_from_name(const char *name)
+{
+  if (strcmp(name, "fork") == 0)
+  {
+    return SPAWN_FORK;
+  }
+  else if (strcmp(name, "posix") == 0)
+  {
+    return SPAWN_POSIX;
+  }
+  return -1;
+}
+
+const char *spawn_backend_name(spawn_backend_t backend)
+{
+  return backend == SPAWN_FORK ? "fork" : "posix";
+}
+
+// launching the program described by the request without waiting for it
+
+pid_t spawn_process(const spawn_request_t *request)
+{
+  // anything still sitting in our stdout buffer would otherwise end up after the child's output (or be flushed twice after a fork)
+  fflush(stdout);
+
+  uint64_t start = stats_now();
+  pid_t pid;
+  trace_event(TRACE_FORK, request->argv, -1, 0);
+
+  // a builtin can only run inside a copy of the shell
+  if (request->child_fn != NULL)
+  {
+    pid = spawn_fork(request, NULL);
+    stats_record(STAT_SPAWN, start);
+    trace_event(TRACE_EXEC, request->argv, pid, (pid == -1) ? errno : 0);
+    return pid;
+  }
+
+  // resolving the program through the PATH cache, so that exec doesn't have to go through every directory in $PATH each time
+  // (if it isn't found there, execvp/posix_spawnp still get the final say on what happens)
+  const char *path = path_lookup(request->argv[0]);
+  start = stats_record(STAT_LOOKUP, start);
+
+  if (current_backend == SPAWN_FORK)
+  {
+    pid = spawn_fork(request, path);
+  }
+  else
+  {
+    pid = spawn_posix(request, path);
+  }
+  stats_record(STAT_SPAWN, start);
+  trace_event(TRACE_EXEC, request->argv, pid, (pid == -1) ? errno : 0);
+  return pid;
+}
+
+// launching with fork(), setting up the descriptors in the child before calling execv (or execvp if the path is unknown)
+// a child which can't execute the program sends errno back through a pipe closed on exec (kept above every descriptor a
+// redirection can name), so that it is told apart from a program exiting with 127, just like posix_spawn does
+
+static pid_t spawn_fork(const spawn_request_t *request, const char *path)
+{
+  int report[2] = {-1, -1};
+  if (request->child_fn == NULL)
+  {
+    if (pipe(report) == -1)
+    {
+      return -1;
+    }
+    for (int end = 0; end < 2; ++end)
+    {
+      int moved = fcntl(report[end], F_DUPFD_CLOEXEC, 10);
+      close(report[end]);
+      report[end] = moved;
+    }
+    if (report[0] == -1 || report[1] == -1)
+    {
+      close(report[0]);
+      close(report[1]);
+      return -1;
+    }
+  }
+
+  pid_t pid = fork();
+
+  if (pid == 0)
+  {
+    if (request->set_pgid)
+    {
+      setpgid(0, request->pgid);
+    }
+
+    if (request->in_fd != 0)
+    {
+      dup2(request->in_fd, 0);
+      close(request->in_fd);
+    }
+
+    if (request->out_fd != 1)
+    {
+      dup2(request->out_fd, 1);
+      close(request->out_fd);
+    }
+
+    if (request->close_fd != -1)
+    {
+      close(request->close_fd);
+    }
+
+    for (int index = 0; index < request->num_dups; ++index)
+    {
+      const spawn_dup_t *action = &request->dups[index];
+      if (action->source == -1)
+      {
+        close(action->fd);
+      }
+      else if (dup2(action->source, action->fd) == -1)
+      {
+        fprintf(stderr, "%d: %s\n", action->source, strerror(errno));
+        _exit(1);
+      }
+    }
+
+    if (request->child_fn != NULL)
+    {
+      int result = request->child_fn(request->argv);
+      fflush(stdout);
+      _exit(result);
+    }
+
+    if (path != NULL)
+    {
+      execv(path, request->argv);
+    }
+    else
+    {
+      execvp(request->argv[0], request->argv);
+    }
+    int error = errno;
+    write(report[1], &error, sizeof(error));
+    _exit(127); // the same status as every other shell uses for a command which couldn't be found
+  }
+
+  if (report[0] != -1)
+  {
+    close(report[1]);
+    int error;
+    ssize_t got;
+    while ((got = read(report[0], &error, sizeof(error))) == -1 && errno == EINTR)
+    {
+    }
+    close(report[0]);
+    if (pid > 0 && got == sizeof(error))
+    {
+      waitpid(pid, NULL, 0);
+      errno = error;
+      return -1;
+    }
+  }
+
+  // the parent does it as well, so that the group exists by the time the next stage of the pipeline joins it
+  if (pid > 0 && request->set_pgid)
+  {
+    setpgid(pid, request->pgid ? request->pgid : pid);
+  }
+
+  return pid;
+}
+
+// launching with posix_spawn() (or posix_spawnp() if the path is unknown), describing the descriptor set-up as file actions
+
+static pid_t spawn_posix(const spawn_request_t *request, const char *path)
+{
+  posix_spawn_file_actions_t actions;
+  posix_spawnattr_t attributes;
+  pid_t pid;
+
+  posix_spawn_file_actions_init(&actions);
+  posix_spawnattr_init(&attributes);
+
+  if (request->set_pgid)
+  {
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attributes, request->pgid);
+  }
+
+  if (request->in_fd != 0)
+  {
+    posix_spawn_file_actions_adddup2(&actions, request->in_fd, 0);
+    posix_spawn_file_actions_addclose(&actions, request->in_fd);
+  }
+
+  if (request->out_fd != 1)
+  {
+    posix_spawn_file_actions_adddup2(&actions, request->out_fd, 1);
+    posix_spawn_file_actions_addclose(&actions, request->out_fd);
+  }
+
+  if (request->close_fd != -1)
+  {
+    posix_spawn_file_actions_addclose(&actions, request->close_fd);
+  }
+
+  for (int index = 0; index < request->num_dups; ++index)
+  {
+    const spawn_dup_t *action = &request->dups[index];
+    if (action->source == -1)
+    {
+      posix_spawn_file_actions_addclose(&actions, action->fd);
+    }
+    else
+    {
+      posix_spawn_file_actions_adddup2(&actions, action->source, action->fd);
+    }
+  }
+
+  int error;
+  if (path != NULL)
+  {
+    error = posix_spawn(&pid, path, &actions, &attributes, request->argv, environ);
+  }
+  else
+  {
+    error = posix_spawnp(&pid, request->argv[0], &actions, &attributes, request->argv, environ);
+  }
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attributes);
+
+  if (error != 0)
+  {
+    errno = error;
+    return -1;
+  }
+  return pid;
+}
@@ -0,0 +1,54 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// (not _SPAWN_H, which is already taken by the system <spawn.h>)
+#ifndef _SHELL_SPAWN_H
+#define _SHELL_SPAWN_H
+
+#include <sys/types.h>
+
+// the ways a new process can be launched
+typedef enum
+{
+  SPAWN_FORK,  // fork() followed by execvp() in the child
+  SPAWN_POSIX, // posix_spawnp(), which avoids copying the shell's page tables
+} spawn_backend_t;
+
+// one of the descriptors of the child being replaced, for a redirection
+typedef struct spawn_dup
+{
+  int fd;     // the descriptor of the child
+  int source; // the descriptor it becomes a copy of (as it is at that point in the child), or -1 for closing it
+} spawn_dup_t;
+
+// everything needed to launch a single program
+typedef struct spawn_request
+{
+  char *const *argv; // the program and its arguments, terminated by NULL
+  int in_fd;         // descriptor to use as stdin (0 to inherit the shell's)
+  int out_fd;        // descriptor to use as stdout (1 to inherit the shell's)
+  int close_fd;      // an extra descriptor the child must not keep open (-1 for none)
+  const spawn_dup_t *dups; // applied in order once stdin and stdout are in place (the redirections of the program)
+  int num_dups;
+  int set_pgid;      // when set, the child is moved to the process group pgid (0 for a new group led by the child)
+  pid_t pgid;
+
+  // when set, the child calls this instead of executing argv[0] and exits with its result
+  // (this can only be done in a copy of the shell, so it always goes through fork())
+  int (*child_fn)(char *const *argv);
+} spawn_request_t;
+
+// selecting the backend used by spawn_process
+void spawn_set_backend(spawn_backend_t backend);
+spawn_backend_t spawn_get_backend();
+
+// converting between a backend and its name ("fork" or "posix"); returns -1 for an unknown name
+int spawn_backend_from_name(const char *name);
+const char *spawn_backend_name(spawn_backend_t backend);
+
+// launching the program described by the request without waiting for it
+// returns the pid of the child, or -1 (with errno set) if the program could not be started
+pid_t spawn_process(const spawn_request_t *request);
+
+#endif /* _SHELL_SPAWN_H */
@@ -0,0 +1,246 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ************** Including the necessary header file **************
+
+#include "stats.h"
+
+// ************** Define macros **************
+
+#define NUM_BUCKETS 64 // bucket n holds the durations of 2^n up to 2^(n + 1) nanoseconds
+#define BAR_WIDTH 40   // the length of the longest bar of a histogram
+
+// ************** Define global variables **************
+
+// the durations recorded for one kind of work
+struct histogram
+{
+  uint64_t count;
+  uint64_t sum;
+  uint64_t min;
+  uint64_t max;
+  uint64_t buckets[NUM_BUCKETS];
+};
+
+static struct histogram histograms[NUM_STATS]; // one for every kind, all of them zeroed to begin with
+
+static const char *const stat_names[NUM_STATS] = {"tokenize", "parse", "lookup", "spawn", "wait", "command"};
+
+// ************** Declaring helper functions **************
+
+static int bucket_of(uint64_t ns);
+static const char *format_duration(char *buffer, size_t size, uint64_t ns);
+static uint64_t percentile(const struct histogram *histogram, int percent);
+static uint64_t timeval_ns(const struct timeval *time);
+
+// ************** Defining the functions **************
+
+// the current time on the monotonic clock (which never jumps), in nanoseconds
+
+uint64_t stats_now()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+// the bucket a duration falls into: the position of its highest bit
+
+static int bucket_of(uint64_t ns)
+{
+  return 63 - __builtin_clzll(ns | 1);
+}
+
+// adding the time since start to the histogram of the given kind
+
+uint64_t stats_record(stat_kind_t kind, uint64_t start)
+{
+  uint64_t now = stats_now();
+  uint64_t ns = now - start;
+  struct histogram *histogram = &histograms[kind];
+
+  if (histogram->count == 0 || ns < histogram->min)
+  {
+    histogram->min = ns;
+  }
+  if (ns > histogram->max)
+  {
+    histogram->max = ns;
+  }
+  histogram->count++;
+  histogram->sum += ns;
+  histogram->buckets[bucket_of(ns)]++;
+  return now;
+}
+
+// writing a duration with a unit which keeps it short (850ns, 12.3us, 4.56ms, 1.23s)
+
+static const char *format_duration(char *buffer, size_t size, uint64_t ns)
+{
+  if (ns < 1000)
+  {
+    snprintf(buffer, size, "%lluns", (unsigned long long)ns);
+  }
+  else if (ns < 1000000)
+  {
+    snprintf(buffer, size, "%.1fus", ns / 1e3);
+  }
+  else if (ns < 1000000000)
+  {
+    snprintf(buffer, size, "%.2fms", ns / 1e6);
+  }
+  else
+  {
+    snprintf(buffer, size, "%.2fs", ns / 1e9);
+  }
+  return buffer;
+}
+
+// finding the duration which the given percentage of the recorded ones don't go over
+// only the bucket is known, so this is the upper end of the bucket (which never goes past the longest duration recorded)
+
+static uint64_t percentile(const struct histogram *histogram, int percent)
+{
+  uint64_t wanted = (histogram->count * percent + 99) / 100;
+  uint64_t seen = 0;
+
+  for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+  {
+    seen += histogram->buckets[bucket];
+    if (seen >= wanted)
+    {
+      uint64_t upper = (bucket < 63) ? (2ull << bucket) - 1 : UINT64_MAX;
+      return upper < histogram->max ? upper : histogram->max;
+    }
+  }
+  return histogram->max;
+}
+
+// printing every kind in one table, or the histogram of a single one
+
+int stats_print(const char *name)
+{
+  char text[6][16];
+
+  if (name == NULL)
+  {
+    printf("%-9s %8s %9s %9s %9s %9s %9s\n", "", "count", "mean", "min", "p50", "p99", "max");
+    for (int kind = 0; kind < NUM_STATS; ++kind)
+    {
+      const struct histogram *histogram = &histograms[kind];
+      if (histogram->count == 0)
+      {
+        printf("%-9s %8d %9s %9s %9s %9s %9s\n", stat_names[kind], 0, "-", "-", "-", "-", "-");
+        continue;
+      }
+      printf("%-9s %8llu %9s %9s %9s %9s %9s\n", stat_names[kind], (unsigned long long)histogram->count,
+             format_duration(text[0], sizeof(text[0]), histogram->sum / histogram->count),
+             format_duration(text[1], sizeof(text[1]), histogram->min),
+             format_duration(text[2], sizeof(text[2]), percentile(histogram, 50)),
+             format_duration(text[3], sizeof(text[3]), percentile(histogram, 99)),
+             format_duration(text[4], sizeof(text[4]), histogram->max));
+    }
+    return 0;
+  }
+
+  int kind = 0;
+  while (kind < NUM_STATS && strcmp(stat_names[kind], name) != 0)
+  {
+    kind++;
+  }
+  if (kind == NUM_STATS)
+  {
+    return -1;
+  }
+
+  const struct histogram *histogram = &histograms[kind];
+  uint64_t tallest = 0;
+  for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+  {
+    if (histogram->buckets[bucket] > tallest)
+    {
+      tallest = histogram->buckets[bucket];
+    }
+  }
+
+  printf("%s: %llu recorded\n", name, (unsigned long long)histogram->count);
+  for (int bucket = 0; bucket < NUM_BUCKETS - 1; ++bucket)
+  {
+    if (histogram->buckets[bucket] == 0)
+    {
+      continue;
+    }
+    int width = (int)((histogram->buckets[bucket] * BAR_WIDTH + tallest - 1) / tallest);
+    printf("  %9s - %-9s %8llu %.*s\n", format_duration(text[0], sizeof(text[0]), 1ull << bucket),
+           format_duration(text[1], sizeof(text[1]), 2ull << bucket), (unsigned long long)histogram->buckets[bucket], width,
+           "########################################");
+  }
+  return 0;
+}
+
+// forgetting everything recorded so far
+
+void stats_reset()
+{
+  memset(histograms, 0, sizeof(histograms));
+}
+
+// converting a time reported by getrusage/wait4 into nanoseconds
+
+static uint64_t timeval_ns(const struct timeval *time)
+{
+  return (uint64_t)time->tv_sec * 1000000000u + (uint64_t)time->tv_usec * 1000u;
+}
+
+// turning what wait4 reported for a child launched at start into what it used up
+
+void usage_from_rusage(run_usage_t *usage, const struct rusage *rusage, uint64_t start)
+{
+  usage->real_ns = stats_now() - start;
+  usage->user_ns = timeval_ns(&rusage->ru_utime);
+  usage->sys_ns = timeval_ns(&rusage->ru_stime);
+  usage->max_rss_kb = rusage->ru_maxrss;
+}
+
+// measuring what the shell uses up from now on
+
+void usage_start(usage_mark_t *mark)
+{
+  getrusage(RUSAGE_SELF, &mark->self);
+  getrusage(RUSAGE_CHILDREN, &mark->children);
+  mark->start = stats_now();
+}
+
+// working out what the shell (and every child it reaped) used up since usage_start
+// the peak memory can't be taken apart like the times can, so it is the largest of the shell's and of any child's so far
+
+void usage_stop(const usage_mark_t *mark, run_usage_t *usage)
+{
+  struct rusage self, children;
+  usage->real_ns = stats_now() - mark->start;
+  getrusage(RUSAGE_SELF, &self);
+  getrusage(RUSAGE_CHILDREN, &children);
+
+  usage->user_ns = timeval_ns(&self.ru_utime) - timeval_ns(&mark->self.ru_utime) + timeval_ns(&children.ru_utime) -
+                   timeval_ns(&mark->children.ru_utime);
+  usage->sys_ns = timeval_ns(&self.ru_stime) - timeval_ns(&mark->self.ru_stime) + timeval_ns(&children.ru_stime) -
+                  timeval_ns(&mark->children.ru_stime);
+  usage->max_rss_kb = (self.ru_maxrss > children.ru_maxrss) ? self.ru_maxrss : children.ru_maxrss;
+}
+
+// printing what something used up to stderr (just like other shells do, so it never ends up in a redirected stdout)
+
+void usage_print(const char *label, const run_usage_t *usage)
+{
+  fflush(stdout); // whatever was printed before still comes first
+  fprintf(stderr, "%sreal %.3fs  user %.3fs  sys %.3fs  maxrss %ld KB\n", label, usage->real_ns / 1e9, usage->user_ns / 1e9,
+          usage->sys_ns / 1e9, usage->max_rss_kb);
+}
@@ -0,0 +1,65 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <stdint.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+// the parts of running a command which are timed for the stats builtin
+typedef enum stat_kind
+{
+  STAT_TOKENIZE, // turning a command into tokens
+  STAT_PARSE,    // turning the tokens into pipelines
+  STAT_LOOKUP,   // finding a program in the table of command paths (or in $PATH)
+  STAT_SPAWN,    // launching a program: the fork, or the whole posix_spawn (which only returns once the program is executed)
+  STAT_WAIT,     // waiting for a program run in the foreground to finish
+  STAT_COMMAND,  // running a whole command, from its tokens to the end of its last program
+  NUM_STATS
+} stat_kind_t;
+
+// what running something used up, as reported by time
+typedef struct run_usage
+{
+  uint64_t real_ns;
+  uint64_t user_ns;
+  uint64_t sys_ns;
+  long max_rss_kb; // the most memory it had at any point
+} run_usage_t;
+
+// where the shell was at when it started running something itself, for measuring what that used up
+typedef struct usage_mark
+{
+  uint64_t start;
+  struct rusage self;     // what the shell had used up so far
+  struct rusage children; // and what the children it had reaped so far had
+} usage_mark_t;
+
+// the current time on the monotonic clock, in nanoseconds
+uint64_t stats_now();
+
+// adding the time since start (from stats_now) to the histogram of the given kind, and returning the current time
+// the histograms have a fixed number of buckets, so this never allocates and costs little more than reading the clock
+uint64_t stats_record(stat_kind_t kind, uint64_t start);
+
+// printing how long every kind took (with name NULL), or the whole histogram of the kind with the given name
+// returns -1 if there is no kind with that name
+int stats_print(const char *name);
+
+// forgetting everything recorded so far
+void stats_reset();
+
+// turning what wait4 reported for a child launched at start (from stats_now) into what it used up
+void usage_from_rusage(run_usage_t *usage, const struct rusage *rusage, uint64_t start);
+
+// measuring what the shell (along with every child it reaps in the meantime) uses up from now on, until usage_stop
+void usage_start(usage_mark_t *mark);
+void usage_stop(const usage_mark_t *mark, run_usage_t *usage);
+
+// printing what something used up to stderr, after the label (which can be empty)
+void usage_print(const char *label, const run_usage_t *usage);
+
+#endif /* _STATS_H */
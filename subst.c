@@ -0,0 +1,432 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#define _GNU_SOURCE // for memfd_create
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+// ************** Including the necessary header files **************
+
+#include "subst.h"
+#include "copy.h"
+#include "tokens.h"
+
+// ************** Define macros **************
+
+#define CAPTURE_START 4096      // the size of the buffer an output is first read into
+#define CAPTURE_MAP_SIZE (1 << 20) // how large the buffer may grow before the rest of the output goes into a memfd
+
+#define RUN_SUBST 1 // a substitution the shell runs itself (see find_runs)
+#define RUN_GROUP 2 // a token inside a group, which its subshell expands
+
+// ************** Declaring helper functions **************
+
+static int capture_rest(int fd, capture_t *capture);
+static size_t split_words(capture_t *capture, char **words);
+static size_t find_runs(const char *const *tokens, const unsigned char *types, size_t num_tokens, unsigned char *runs);
+static char *whole_output(capture_t *capture);
+static long long glue_pieces(char **pieces, unsigned char *types, const unsigned char *glued, size_t num_pieces, char **joined);
+
+// ************** Defining the functions **************
+
+// reading everything from fd (until EOF) into capture
+
+int capture_fd(int fd, capture_t *capture)
+{
+  capture->data = malloc(CAPTURE_START);
+  capture->size = 0;
+  capture->capacity = CAPTURE_START;
+  capture->mapped = 0;
+  if (capture->data == NULL)
+  {
+    return -1;
+  }
+
+  int can_map = 1; // whether a memfd can still take over
+  while (1)
+  {
+    // the buffer is full (but for the spare byte)
+    if (capture->size + 1 == capture->capacity)
+    {
+      if (can_map && capture->capacity >= CAPTURE_MAP_SIZE)
+      {
+        int result = capture_rest(fd, capture);
+        if (result != 1)
+        {
+          return result;
+        }
+        can_map = 0; // there is no memfd to be had, so the buffer keeps growing
+      }
+
+      char *grown = realloc(capture->data, 2 * capture->capacity);
+      if (grown == NULL)
+      {
+        capture_free(capture);
+        return -1;
+      }
+      capture->data = grown;
+      capture->capacity *= 2;
+    }
+
+    ssize_t got = read(fd, &capture->data[capture->size], capture->capacity - 1 - capture->size);
+    if (got == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (got == -1)
+    {
+      capture_free(capture);
+      return -1;
+    }
+    if (got == 0)
+    {
+      return 0;
+    }
+    capture->size += got;
+  }
+}
+
+// moving what has been read so far and the rest of fd into a memfd (from a pipe, by splicing it inside the kernel), and mapping
+// the whole of it in place of the buffer
+// returns 0, -1 if reading failed, or 1 if there is no memfd to be had (with the capture as it was)
+
+static int capture_rest(int fd, capture_t *capture)
+{
+  int memfd = memfd_create("substitution", MFD_CLOEXEC);
+  if (memfd == -1)
+  {
+    return 1;
+  }
+
+  for (size_t written = 0; written < capture->size;)
+  {
+    ssize_t count = write(memfd, &capture->data[written], capture->size - written);
+    if (count == -1 && errno != EINTR)
+    {
+      close(memfd);
+      capture_free(capture);
+      return -1;
+    }
+    written += (count > 0) ? count : 0;
+  }
+
+  long long rest = copy_fd(fd, memfd);
+  size_t size = capture->size + (rest > 0 ? rest : 0);
+  char *data = MAP_FAILED;
+  // (the spare byte is added to the end of the memfd, so that it is mapped as well)
+  if (rest != -1 && ftruncate(memfd, size + 1) == 0)
+  {
+    data = mmap(NULL, size + 1, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+  }
+  close(memfd);
+
+  capture_free(capture);
+  if (data == MAP_FAILED)
+  {
+    return -1;
+  }
+  capture->data = data;
+  capture->size = size;
+  capture->capacity = size + 1;
+  capture->mapped = 1;
+  return 0;
+}
+
+// giving back the memory held by a capture
+
+void capture_free(capture_t *capture)
+{
+  if (capture->mapped)
+  {
+    munmap(capture->data, capture->capacity);
+  }
+  else
+  {
+    free(capture->data);
+  }
+  capture->data = NULL;
+  capture->size = 0;
+  capture->capacity = 0;
+  capture->mapped = 0;
+}
+
+// splitting the output at spaces, tabs and newlines, ending every word with a \0 in place and storing it in words
+// (only counting the words when words is NULL)
+// returns the number of words
+
+static size_t split_words(capture_t *capture, char **words)
+{
+  size_t count = 0;
+  char *data = capture->data;
+
+  for (size_t index = 0; index < capture->size;)
+  {
+    while (index < capture->size && (data[index] == ' ' || data[index] == '\t' || data[index] == '\n'))
+    {
+      ++index;
+    }
+    if (index == capture->size)
+    {
+      break;
+    }
+
+    size_t start = index;
+    while (index < capture->size && data[index] != ' ' && data[index] != '\t' && data[index] != '\n')
+    {
+      ++index;
+    }
+    if (words != NULL)
+    {
+      data[index] = '\0'; // (at the end of the output, this is the spare byte)
+      words[count] = &data[start];
+    }
+    ++count;
+    ++index;
+  }
+  return count;
+}
+
+// working out which substitutions the shell runs itself: all of them but those inside a group ( ... ), which its subshell expands
+// as it runs the commands of the group (each one right before the command it is part of); a ( starts a group only where it
+// starts a stage, just like in parse_command
+// returns how many substitutions are to be run, with runs[n] set to RUN_SUBST for each of them and to RUN_GROUP for every token
+// inside a group
+
+static size_t find_runs(const char *const *tokens, const unsigned char *types, size_t num_tokens, unsigned char *runs)
+{
+  size_t num_runs = 0;
+  int stage_start = 1; // whether the next token starts a stage
+
+  for (size_t index = 0; index < num_tokens; ++index)
+  {
+    int type = TOKEN_TYPE(types[index]);
+    if (type == TOKEN_LPAREN && stage_start)
+    {
+      for (int depth = 1; depth > 0 && index + 1 < num_tokens;)
+      {
+        ++index;
+        depth += (types[index] == TOKEN_LPAREN) - (types[index] == TOKEN_RPAREN);
+        runs[index] = (depth > 0) ? RUN_GROUP : 0;
+      }
+      stage_start = 0;
+      continue;
+    }
+    if (type == TOKEN_SUBST || type == TOKEN_SUBST_QUOTED)
+    {
+      runs[index] = RUN_SUBST;
+      ++num_runs;
+    }
+
+    // a stage starts after a |, ; or &, or after the time a pipeline starts with (a & of a redirection doesn't matter here, as
+    // a ( can't come right after it anyway)
+    stage_start = (type == TOKEN_PIPE || type == TOKEN_SEMI || type == TOKEN_AMP) ||
+                  (stage_start && type == TOKEN_WORD && strcmp(tokens[index], "time") == 0);
+  }
+  return num_runs;
+}
+
+// dropping the newlines an output ends with, as they are never part of its last word (the output of a quoted substitution is
+// otherwise taken as it is)
+// returns the output as a single word, ended by a \0 in place
+
+static char *whole_output(capture_t *capture)
+{
+  while (capture->size > 0 && capture->data[capture->size - 1] == '\n')
+  {
+    --capture->size;
+  }
+  capture->data[capture->size] = '\0'; // (the spare byte, when the output didn't end with a newline)
+  return capture->data;
+}
+
+// gluing the pieces of the words which are made of several of them (those with glued[n] set go onto the piece before them) into
+// one word each, written one after another into joined; the words are then moved down over the pieces
+// returns the number of words, or -1 if there was no memory for them
+
+static long long glue_pieces(char **pieces, unsigned char *types, const unsigned char *glued, size_t num_pieces, char **joined)
+{
+  size_t size = 0;
+  for (size_t index = 0; index < num_pieces; ++index)
+  {
+    int in_word = glued[index] || (index + 1 < num_pieces && glued[index + 1]);
+    size += in_word ? strlen(pieces[index]) + 1 : 0;
+  }
+  *joined = NULL;
+  if (size == 0)
+  {
+    return num_pieces;
+  }
+  *joined = malloc(size);
+  if (*joined == NULL)
+  {
+    return -1;
+  }
+
+  size_t count = 0;
+  char *end = *joined;
+  for (size_t index = 0; index < num_pieces; ++index)
+  {
+    if (index + 1 == num_pieces || !glued[index + 1])
+    {
+      pieces[count] = pieces[index];
+      types[count++] = types[index];
+      continue;
+    }
+
+    // the first piece of a word, and every one glued onto it
+    char *word = end;
+    do
+    {
+      size_t len = strlen(pieces[index]);
+      memcpy(end, pieces[index], len);
+      end += len;
+    } while (++index < num_pieces && glued[index]);
+    --index;
+    *end++ = '\0';
+    pieces[count] = word;
+    types[count++] = TOKEN_WORD;
+  }
+  return count;
+}
+
+// replacing the substitutions the shell runs itself by the words of their output (see find_runs)
+// the output of a substitution is glued to the word before it and the word after it when they are joined to it (see TOKEN_JOINED),
+// unless it starts or ends with a space, tab or newline (but for the newlines it ends with, which are always dropped)
+
+int expand_substitutions(const char *const *tokens, const unsigned char *types, subst_runner_t run, expansion_t *expansion)
+{
+  size_t num_tokens = 0;
+  while (tokens[num_tokens] != NULL)
+  {
+    ++num_tokens;
+  }
+
+  expansion->tokens = NULL;
+  expansion->types = NULL;
+  expansion->num_tokens = 0;
+  expansion->num_captures = 0;
+  expansion->joined = NULL;
+  unsigned char *runs = calloc(num_tokens + 1, 1);
+  if (runs == NULL)
+  {
+    expansion->captures = NULL;
+    return -1;
+  }
+  size_t num_runs = find_runs(tokens, types, num_tokens, runs);
+  expansion->captures = calloc(num_runs + 1, sizeof(capture_t));
+  if (expansion->captures == NULL)
+  {
+    free(runs);
+    return -1;
+  }
+
+  // every substitution is run first (in order), to know how many words there will be at most
+  size_t num_words = num_tokens;
+  for (size_t index = 0; index < num_tokens; ++index)
+  {
+    if (runs[index] != RUN_SUBST)
+    {
+      continue;
+    }
+    capture_t *capture = &expansion->captures[expansion->num_captures];
+    if (run(tokens[index], capture) == -1)
+    {
+      free(runs);
+      expansion_free(expansion);
+      return -1;
+    }
+    ++expansion->num_captures;
+    num_words += split_words(capture, NULL);
+  }
+
+  expansion->tokens = malloc((num_words + 1) * sizeof(char *));
+  expansion->types = malloc(num_words + 1);
+  unsigned char *glued = calloc(num_words + 1, 1); // which pieces go onto the one before them
+  if (expansion->tokens == NULL || expansion->types == NULL || glued == NULL)
+  {
+    free(runs);
+    free(glued);
+    expansion_free(expansion);
+    return -1;
+  }
+
+  size_t count = 0;
+  int open = 0; // whether the last piece is a word which the next piece can be glued onto
+  capture_t *capture = expansion->captures;
+  for (size_t index = 0; index < num_tokens; ++index)
+  {
+    // (the tokens inside a group are left as they are, TOKEN_JOINED and all, for its subshell)
+    int joined = (types[index] & TOKEN_JOINED) && runs[index] != RUN_GROUP;
+    open = open && joined;
+    size_t first = count;
+
+    if (runs[index] != RUN_SUBST)
+    {
+      expansion->tokens[count] = (char *)tokens[index];
+      expansion->types[count++] = (runs[index] == RUN_GROUP) ? types[index] : TOKEN_TYPE(types[index]);
+      glued[first] = open;
+      open = 1;
+      continue;
+    }
+
+    if (TOKEN_TYPE(types[index]) == TOKEN_SUBST_QUOTED)
+    {
+      expansion->tokens[count] = whole_output(capture++);
+      expansion->types[count++] = TOKEN_WORD;
+      glued[first] = open;
+      open = 1;
+      continue;
+    }
+
+    // an output made of nothing but newlines leaves the words around it joined to each other
+    const char *data = capture->data;
+    whole_output(capture);
+    int apart_before = capture->size > 0 && (data[0] == ' ' || data[0] == '\t' || data[0] == '\n');
+    int apart_after = capture->size > 0 && (data[capture->size - 1] == ' ' || data[capture->size - 1] == '\t');
+    size_t words = split_words(capture++, &expansion->tokens[count]);
+    memset(&expansion->types[count], TOKEN_WORD, words);
+    count += words;
+    glued[first] = open && !apart_before;
+    open = (words > 0 || (open && !apart_before)) && !apart_after;
+  }
+  free(runs);
+
+  long long num_glued = glue_pieces(expansion->tokens, expansion->types, glued, count, &expansion->joined);
+  free(glued);
+  if (num_glued == -1)
+  {
+    expansion_free(expansion);
+    return -1;
+  }
+  expansion->tokens[num_glued] = NULL;
+  expansion->types[num_glued] = 0;
+  expansion->num_tokens = num_glued;
+  return 0;
+}
+
+// giving back the memory held by an expansion, along with the outputs its tokens point into
+
+void expansion_free(expansion_t *expansion)
+{
+  for (size_t index = 0; index < expansion->num_captures; ++index)
+  {
+    capture_free(&expansion->captures[index]);
+  }
+  free(expansion->captures);
+  free(expansion->tokens);
+  free(expansion->types);
+  free(expansion->joined);
+  expansion->captures = NULL;
+  expansion->num_captures = 0;
+  expansion->tokens = NULL;
+  expansion->types = NULL;
+  expansion->joined = NULL;
+  expansion->num_tokens = 0;
+}
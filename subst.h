@@ -0,0 +1,54 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _SUBST_H
+#define _SUBST_H
+
+#include <stddef.h>
+
+// everything a command substitution wrote, kept in memory (never in a temporary file)
+// it is read into a buffer growing as needed, and once it gets large the rest is moved into a memfd inside the kernel and the
+// whole of it mapped, so a large output is neither copied over and over as the buffer grows nor read through user space at all
+typedef struct capture
+{
+  char *data;      // the output, followed by one spare byte (so that its last word can be ended by a \0 in place)
+  size_t size;     // how many bytes of output there are
+  size_t capacity; // the size of the buffer, or of the mapping when it is mapped
+  int mapped;      // whether data is a mapping of a memfd (rather than a buffer from malloc)
+} capture_t;
+
+// the tokens of a command after every substitution in it has been replaced by the words of its output
+typedef struct expansion
+{
+  char **tokens;          // the tokens, terminated by NULL
+  unsigned char *types;   // the type of each token, in step with tokens
+  size_t num_tokens;
+  capture_t *captures;    // the outputs the words point into
+  size_t num_captures;
+  char *joined;           // the words glued together out of several pieces (as the abc of a$(echo b)c), or NULL if there are none
+} expansion_t;
+
+// what runs the command of a substitution, capturing its output into capture
+// returns the exit status of the command, or -1 if it couldn't be run or its output couldn't be read
+typedef int (*subst_runner_t)(const char *cmd, capture_t *capture);
+
+// reading everything from fd (until EOF) into capture
+// returns 0, or -1 (with errno set) if reading failed or there was no memory for it
+int capture_fd(int fd, capture_t *capture);
+
+// giving back the memory held by a capture
+void capture_free(capture_t *capture);
+
+// replacing every substitution among the tokens (terminated by NULL) by the words of its output, as run by run: the output is
+// split at spaces, tabs and newlines, and every piece of it is a word (so an operator in the output is never one to the command),
+// the first and last of which are glued to the text right before and after the substitution; the output of a quoted substitution
+// is a single word, whatever it holds (but for the newlines it ends with)
+// the substitutions inside a group ( ... ) are left as they are, for its subshell to expand
+// returns 0, or -1 if one of the substitutions couldn't be run (nothing has to be freed then)
+int expand_substitutions(const char *const *tokens, const unsigned char *types, subst_runner_t run, expansion_t *expansion);
+
+// giving back the memory held by an expansion, along with the outputs its tokens point into
+void expansion_free(expansion_t *expansion);
+
+#endif /* _SUBST_H */
@@ -9,12 +9,19 @@ import sys
 import subprocess
 import random
 import re
+import json
+import tempfile
+import time
+import signal
 
 from shell_test_helpers import *
 
 TOKENIZE = "./tokenize"
 SHELL = "./shell"
 
+# the tests never touch the history of whoever runs them (the history tests give the shell a file of their own)
+os.environ["MINISHELL_HISTORY"] = ""
+
 class ShellTests(ShellTestCase):
     def __init__(self, *args, **kwargs):
         super().__init__(SHELL, *args, **kwargs)
@@ -105,6 +112,351 @@ class ShellTests(ShellTestCase):
         actual = self.run_shell(script)
         self.assertEqual(actual, "one\ntwo\nthree")
 
+    def test10(self):
+        """ Pipelines stream multi-megabyte data through three stages """
+        actual = self.run_shell("head -c 8000000 /dev/zero | cat | wc -c")
+        self.assertEqual(actual, "8000000")
+
+    def test11(self):
+        """ Pipelines with four stages run concurrently """
+        script = "seq 1 1000000 | grep 7 | sort -r | wc -l"
+        actual = self.run_shell(script)
+        expected = sh(script)
+        self.assertEqual(actual, expected)
+
+    def test12(self):
+        """ The hash builtin remembers command paths and counts hits """
+        script = "hash -r\nls > /dev/null\nls > /dev/null\nhash"
+        actual = self.run_shell(script)
+        self.assertRegex(actual, r"\s1\t/\S*/ls\n")
+        self.assertRegex(actual, r"lookups: 1 hits, 1 misses$")
+
+    def test13(self):
+        """ Commands with 10k arguments work """
+        args = " ".join(f"arg{i}" for i in range(10000))
+        actual = self.run_shell(f"echo {args} | wc -w")
+        self.assertEqual(actual, "10000")
+
+    def test14(self):
+        """ 1 MB lines work, at the prompt and through source """
+        words = ["x" * 99 + str(i % 10) for i in range(10500)]
+        line = "echo " + " ".join(words)
+        self.assertGreater(len(line), 1 << 20)
+
+        actual = self.run_shell(line)
+        self.assertEqual(actual, " ".join(words))
+
+        with tempfile.NamedTemporaryFile("w", suffix = ".sh") as script:
+            script.write(line + " | wc -c\n")
+            script.flush()
+            actual = self.run_shell(f"source {script.name}")
+        self.assertEqual(actual, str(len(line) - len("echo ") + 1))
+
+    def test15(self):
+        """ Sourcing a script again picks up changes to it """
+        with tempfile.NamedTemporaryFile("w", suffix = ".sh") as script:
+            script.write("echo one; echo two\n")
+            script.flush()
+            rewrite = f'echo "echo three" > {script.name}'
+            actual = self.run_shell(f"source {script.name}\nsource {script.name}\n{rewrite}\nsource {script.name}")
+        self.assertEqual(actual, "one\ntwo\none\ntwo\nthree")
+
+    def test16(self):
+        """ A large script (run straight out of the file) may cut itself short """
+        with tempfile.NamedTemporaryFile("w", suffix = ".sh") as script:
+            script.write(f"echo first\necho cut > {script.name}\n" + ("cd . " + "x" * 100 + "\n") * 20000 + "echo never\n")
+            script.flush()
+            actual = self.run_shell(f"source {script.name}\necho after")
+        self.assertEqual(actual, "first\nafter")
+
+    def test17(self):
+        """ Commands ending with & run in the background until waited for """
+        start = time.monotonic()
+        actual = self.run_shell("sleep 0.5 & sleep 0.5 & echo hi | tr a-z A-Z &\necho now\nwait\necho done")
+        elapsed = time.monotonic() - start
+        lines = [line for line in actual.splitlines() if not re.match(r"^\[\d+\] ", line)] # job numbers, pids and states
+        self.assertEqual(sorted(lines), ["HI", "done", "now"])
+        self.assertLess(lines.index("now"), lines.index("done"))
+        self.assertLess(elapsed, 0.95)
+
+    def test18(self):
+        """ Background jobs are reaped as soon as they finish """
+        actual = self.run_shell('sleep 0.1 &\nsleep 0.4\nsh -c "cat /proc/$PPID/task/$PPID/children"\njobs')
+        lines = actual.splitlines()
+        self.assertRegex(lines[0], r"^\[1\] \d+$")
+        self.assertEqual(lines[1], "[1] Done       sleep 0.1")
+        self.assertEqual(len(lines[2].split()), 1) # nothing but the sh itself
+        self.assertEqual(len(lines), 3)
+
+    def test19(self):
+        """ parallel runs a command per input, with ordered output and a failure count """
+        actual = self.run_shell('parallel -k -j 3 sh -c "sleep 0.{}; echo {}" ::: 3 1 2\n'
+                                'printf "b\\na\\n" | parallel -k echo got\n'
+                                'parallel -k sh -c "exit {}" ::: 0 1 0 2')
+        self.assertEqual(actual, "3\n1\n2\ngot b\ngot a\nparallel: 2 of 4 jobs failed")
+
+    def test20(self):
+        """ parallel keeps N runs going at once """
+        start = time.monotonic()
+        actual = self.run_shell("parallel -j 4 sleep ::: 0.3 0.3 0.3 0.3 0.3 0.3 0.3 0.3")
+        elapsed = time.monotonic() - start
+        self.assertEqual(actual, "")
+        self.assertGreater(elapsed, 0.55)
+        self.assertLess(elapsed, 1.2)
+
+    def test21(self):
+        """ Every program of a pipeline or redirection is a direct child of the shell """
+        report = 'sh -c "echo $$ $PPID; sleep 0.1; cat /proc/$PPID/task/$PPID/children; echo"'
+        with tempfile.TemporaryDirectory() as directory:
+            out = os.path.join(directory, "out")
+            actual = self.run_shell(f"sleep 0.2 | {report} | cat > {out}\ncat {out}\n{report} > {out}\ncat {out}")
+        lines = [line.split() for line in actual.splitlines()]
+        self.assertEqual(len(lines), 4)
+
+        # sleep, sh and cat in the pipeline, each of them a child of the shell (and no other process in between)
+        (sh, shell), children = lines[0], lines[1]
+        self.assertEqual(len(children), 3)
+        self.assertIn(sh, children)
+
+        # nothing but sh for the redirection
+        (sh, redirectShell), children = lines[2], lines[3]
+        self.assertEqual(redirectShell, shell)
+        self.assertEqual(children, [sh])
+
+    def test22(self):
+        """ echo, printf, test and pwd run inside the shell, even with redirections and pipes """
+        with tempfile.TemporaryDirectory() as directory:
+            out = os.path.join(directory, "out")
+            script = f'hash -r\necho -n one > {out}\nprintf " %s-%d\\n" two 2 > {out}2\ncat {out} {out}2\n' \
+                     'printf "%s\\n" a b | tr a-z A-Z\ntest 1 -gt 2 | true\n[ -d / ] | true\npwd\nhash'
+            actual = self.run_shell(script)
+        lines = actual.splitlines()
+        self.assertEqual(lines[:5], ["one two-2", "A", "B", "test: exited with status 1 (stage 1)", os.getcwd()])
+
+        # only the program (tr, as a plain cat is run by the shell too) went through the table of command paths
+        commands = sorted(line.split("\t")[1].split("/")[-1] for line in lines[6:-1])
+        self.assertEqual(commands, ["tr"])
+
+    def test23(self):
+        """ Operators inside quotes are words, a stage can have several redirections, and a broken command runs nothing """
+        with tempfile.TemporaryDirectory() as directory:
+            first, second = os.path.join(directory, "first"), os.path.join(directory, "second")
+            script = f'echo "a | b" "<" ">" "&"\necho hi > {first} > {second}\ncat < {second} | tr a-z A-Z\n' \
+                     f'cat {first}\necho x | > {first}\necho y &&\ncat {first} | cat >'
+            actual = self.run_shell(script)
+        self.assertEqual(actual.splitlines(), ["a | b < > &", "HI", "Error: missing command in pipe.",
+                                               "Error: missing command before &.", "Error: missing file for redirection."])
+
+    def test24(self):
+        """ time reports every stage of a pipeline, and stats counts what the shell has done """
+        actual = self.run_shell("time sleep 0.2 | echo hi\ntime true\nstats -r\nhash -r\ncat -u /dev/null\nstats")
+        lines = actual.splitlines()
+        times = r"real (\d+\.\d{3})s  user \d+\.\d{3}s  sys \d+\.\d{3}s  maxrss \d+ KB"
+        self.assertEqual(lines[0], "hi")
+        self.assertRegex(lines[1], "^stage 1 \\(sleep\\): " + times + "$")
+        self.assertRegex(lines[2], "^stage 2 \\(echo\\): " + times + "$")
+        self.assertGreaterEqual(float(re.match("^" + times + "$", lines[3]).group(1)), 0.2)
+        self.assertRegex(lines[4], "^" + times + "$")
+
+        # a single program was looked up, launched and waited for since the reset
+        counts = {line.split()[0]: line.split()[1] for line in lines[6:]}
+        self.assertEqual([counts[kind] for kind in ("lookup", "spawn", "wait")], ["1", "1", "1"])
+
+    def test25(self):
+        """ MINISHELL_TRACE records every event of a command, in order, as JSON lines """
+        with tempfile.TemporaryDirectory() as directory:
+            trace = os.path.join(directory, "trace.jsonl")
+            os.environ["MINISHELL_TRACE"] = trace
+            try:
+                self.run_shell(f"echo hi | cat > {directory}/out")
+            finally:
+                del os.environ["MINISHELL_TRACE"]
+            with open(trace) as source:
+                records = [json.loads(line) for line in source]
+
+        events = [record["event"] for record in records]
+        self.assertEqual(events[:6], ["line_read", "line_begin", "tokenize_begin", "tokenize_end", "command_begin", "run_begin"])
+        self.assertEqual(events[-3:], ["run_end", "command_end", "line_end"])
+        self.assertEqual(sorted(events[6:-3]), sorted(["pipe_create", "fork", "exec", "redirect_open", "fork", "exec",
+                                                        "child_exit", "child_exit"]))
+
+        # every child which was launched was reaped, and the timestamps never go backwards
+        launched = sorted(record["child"] for record in records if record["event"] == "exec")
+        self.assertEqual(launched, sorted(record["child"] for record in records if record["event"] == "child_exit"))
+        self.assertEqual([record["ts"] for record in records], sorted(record["ts"] for record in records))
+
+    def test26(self):
+        """ -c and script files run without the banner or prompts, and a lone program is executed in place of the shell """
+        output = subprocess.run([SHELL, "-c", "echo hi; echo there"], stdout = subprocess.PIPE, stderr = subprocess.STDOUT)
+        self.assertEqual((output.returncode, output.stdout), (0, b"hi\nthere\n"))
+
+        output = subprocess.run([SHELL, "-c", 'sh -c "exit 3"'], stdout = subprocess.PIPE, stderr = subprocess.STDOUT)
+        self.assertEqual(output.returncode, 3) # only its own status would come back from exec
+
+        # otherwise the shell exits with the status of the last command, or with the one given to exit
+        # (the real status, even when it came from a command before the last one, through exit)
+        commands = ("true; false", "false; true", "exit 4", 'true; sh -c "exit 5"', 'sh -c "exit 6"; exit', 'true | sh -c "exit 7"',
+                    'sh -c "exit 8" > /dev/null')
+        statuses = [subprocess.run([SHELL, "-c", command]).returncode for command in commands]
+        self.assertEqual(statuses, [1, 0, 4, 5, 6, 7, 8])
+
+        # only a program which couldn't be started at all is reported as not found
+        output = subprocess.run([SHELL, "-c", 'sh -c "exit 3"; nosuchprogram'], stdout = subprocess.PIPE, stderr = subprocess.STDOUT)
+        self.assertEqual((output.returncode, output.stdout), (127, b"nosuchprogram: command not found\n"))
+
+        with tempfile.TemporaryDirectory() as directory:
+            script = os.path.join(directory, "script.sh")
+            with open(script, "w") as output:
+                output.write(f"#!{os.path.abspath(SHELL)}\necho a | cat\nexit\necho b\n")
+            output = subprocess.run([SHELL, script, "x"], stdout = subprocess.PIPE, stderr = subprocess.STDOUT)
+            self.assertEqual((output.returncode, output.stdout), (0, b"a\n"))
+
+            with open(script, "w") as output:
+                output.write("echo a\nfalse\n")
+            output = subprocess.run([SHELL, script], stdout = subprocess.PIPE, stderr = subprocess.STDOUT)
+            self.assertEqual((output.returncode, output.stdout), (1, b"a\n"))
+
+        output = subprocess.run([SHELL, "/nonexistent/script.sh"], stdout = subprocess.PIPE, stderr = subprocess.STDOUT)
+        self.assertEqual((output.returncode, output.stdout), (127, b"Invalid file path.\n"))
+
+    def test27(self):
+        """ A plain cat and tee copy files and pipes exactly, and cat with options is still the real one """
+        with tempfile.TemporaryDirectory() as directory:
+            data = os.urandom(300000)
+            source = os.path.join(directory, "source")
+            with open(source, "wb") as output:
+                output.write(data)
+
+            actual = self.run_shell(f"cat {source} > {directory}/a\ncat < {source} | tee {directory}/b | cat > {directory}/c\n"
+                                    f"cat {directory}/missing - < {source} > {directory}/d\n"
+                                    f"echo x | tee -a {directory}/e {directory}/e2\necho y | tee -a {directory}/e > /dev/null\n"
+                                    f"cat -n {directory}/e")
+            self.assertEqual([line.strip() for line in actual.splitlines()],
+                             [f"cat: {directory}/missing: No such file or directory", "x", "1\tx", "2\ty"])
+            for name in "abcd":
+                with open(os.path.join(directory, name), "rb") as copy:
+                    self.assertEqual(copy.read(), data)
+
+    def test28(self):
+        """ >>, 2>, 2>&1, &>, <> and n> can be combined freely, and are applied in order """
+        with tempfile.TemporaryDirectory() as directory:
+            d = directory
+            script = f'echo one > {d}/out\necho two >> {d}/out\nls missing {d}/out > {d}/both 2>&1\n' \
+                     f'ls missing 2> {d}/err > /dev/null\nls missing &> {d}/all\necho three 3> {d}/three >&3\necho 2 > {d}/two\n' \
+                     f'echo hi 2>&1 > /dev/null\necho x <> {d}/rw >&7\ncat < {d}/out | tr a-z A-Z 2> {d}/err2 | cat >> {d}/upper'
+            actual = self.run_shell(script)
+            self.assertEqual(actual.splitlines()[-1], "7: Bad file descriptor")
+
+            contents = {}
+            for name in ("out", "both", "err", "all", "three", "two", "rw", "err2", "upper"):
+                with open(os.path.join(directory, name)) as source:
+                    contents[name] = source.read()
+
+        missing = "ls: cannot access 'missing': No such file or directory\n"
+        self.assertEqual(contents, {"out": "one\ntwo\n", "both": missing + f"{directory}/out\n", "err": missing, "all": missing,
+                                    "three": "three\n", "two": "2\n", "rw": "", "err2": "",
+                                    "upper": "ONE\nTWO\n"})
+
+    def test29(self):
+        """ A group ( ... ) runs in a subshell, whose whole output goes through its pipes and redirections """
+        with tempfile.TemporaryDirectory() as directory:
+            actual = self.run_shell(f"(echo a; echo b) | tr a-z A-Z\n(echo x; ls missing) > {directory}/out 2>&1\n"
+                                    f"(echo in; exit)\necho after\n(echo n1; (echo n2 | tr n N))\n(echo a) b")
+            with open(os.path.join(directory, "out")) as source:
+                out = source.read()
+
+        self.assertEqual(actual.splitlines(), ["A", "B", "in", "after", "n1", "N2", "Error: unexpected word after ( )."])
+        self.assertEqual(out.splitlines()[:2], ["x", "ls: cannot access 'missing': No such file or directory"])
+
+    def test30(self):
+        """ $( ... ) is replaced by the words of its output (glued to the text around it), nested or within pipelines, and large outputs are captured whole """
+        actual = self.run_shell('echo $(echo a   b) c\necho $(echo $(echo nested) x) | tr a-z A-Z\necho "<$(printf "a  b\\n")>" [$(true)]\n'
+                                'echo $(echo "; |") done\necho $(seq 1 300000) | wc -w\necho $(head -c 3000000 /dev/zero | tr "\\0" a) | wc -c\n'
+                                'echo a$(echo b)c --x=$(echo y) a$(echo b c)d$(echo e)f a$(printf " b ")c')
+        self.assertEqual(actual.splitlines(), ["a b c", "NESTED X", "<a  b> []", "; | done", "300000", "3000001",
+                                               "abc --x=y ab cdef a b c"])
+
+        # within a group, or in the background, a substitution runs in the subshell, after the commands before it
+        with tempfile.TemporaryDirectory() as directory:
+            output = os.path.join(directory, "output")
+            actual = self.run_shell(f"( cd tests; pwd; echo $(pwd) )\necho $(echo late) > {output} & echo early\nwait\ncat {output}")
+        lines = [line for line in actual.splitlines() if not re.match(r"^\[\d+\] ", line)] # job numbers, pids and states
+        tests = os.path.abspath("tests")
+        self.assertEqual(lines, [tests, tests, "early", "late"])
+
+    def test31(self):
+        """ The history is shared across sessions, and !n, !-n, !!, !prefix and prev run its entries again """
+        with tempfile.TemporaryDirectory() as directory:
+            os.environ["MINISHELL_HISTORY"] = os.path.join(directory, "history")
+            try:
+                first = self.run_shell("echo one\necho two; echo three\nprev\n!!\n!zzz")
+                second = self.run_shell("!1\n!echo t\n!-1\nhistory 3")
+            finally:
+                os.environ["MINISHELL_HISTORY"] = ""
+
+        self.assertEqual(first.splitlines(), ["one", "two", "three", "echo two; echo three", "two", "three",
+                                              "echo two; echo three", "two", "three", "!zzz: event not found"])
+        self.assertEqual([line.strip() for line in second.splitlines()], ["echo one", "one", "echo two; echo three", "two", "three",
+                                               "echo two; echo three", "two", "three",
+                                               "5  echo two; echo three", "6  echo two; echo three", "7  history 3"])
+
+    def test32(self):
+        """ The server runs the commands of each client with its stdin, stdout and stderr, and sends back their status """
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "socket")
+            server = subprocess.Popen([SHELL, "--server", path])
+            try:
+                while not os.path.exists(path):
+                    time.sleep(0.01)
+                first = subprocess.run(["./tools/shell_client", path, "-c", "echo one\nls missing; tr a-z A-Z"], input = b"two",
+                                       stdout = subprocess.PIPE, stderr = subprocess.PIPE)
+                second = subprocess.run(["./tools/shell_client", path, "-c", "false"])
+
+                # a spare worker dying before it takes a connection is replaced (the workers done by now are left alone)
+                def running(pid):
+                    with open(f"/proc/{pid}/stat") as stat:
+                        return stat.read().rsplit(")", 1)[1].split()[0] != "Z"
+                idle = []
+                while not idle:
+                    with open(f"/proc/{server.pid}/task/{server.pid}/children") as children:
+                        idle = [pid for pid in map(int, children.read().split()) if running(pid)]
+                for pid in idle:
+                    os.kill(pid, signal.SIGKILL)
+                third = subprocess.run(["./tools/shell_client", path, "-c", "echo three"], stdout = subprocess.PIPE, timeout = 5)
+            finally:
+                server.terminate()
+                server.wait()
+
+        self.assertEqual(first.stdout.decode().splitlines(), ["one", "TWO"])
+        self.assertEqual(first.stderr.decode(), "ls: cannot access 'missing': No such file or directory\n")
+        self.assertEqual((first.returncode, second.returncode), (0, 1))
+        self.assertEqual((third.returncode, third.stdout), (0, b"three\n"))
+
+    def test33(self):
+        """ cached replays the output of a command run before on the same input without running it, until the input changes """
+        with tempfile.TemporaryDirectory() as directory:
+            os.environ["MINISHELL_CACHE_DIR"] = os.path.join(directory, "cache")
+            runs, source = os.path.join(directory, "runs"), os.path.join(directory, "input")
+            command = f'cached sh -c "echo run >> {runs}; tr a-z A-Z" < {source}'
+            try:
+                with open(source, "w") as output:
+                    output.write("one\n")
+                first = self.run_shell(f"{command}\n{command}\ncached echo built in\ncached echo built in | tr a-z A-Z")
+                with open(source, "w") as output:
+                    output.write("two\n")
+                second = self.run_shell(f"{command}\ncache stats\ncache clear\n{command}")
+            finally:
+                del os.environ["MINISHELL_CACHE_DIR"]
+            with open(runs) as counter:
+                count = len(counter.read().splitlines())
+
+        self.assertEqual(first.splitlines(), ["ONE", "ONE", "built in", "BUILT IN"])
+        lines = second.splitlines()
+        self.assertEqual([lines[0], lines[-1]], ["TWO", "TWO"])
+        self.assertIn("entries: 3", second)
+        self.assertIn("hits: 0, misses: 1, stored: 1", second)
+        self.assertEqual(count, 3)
+
 if __name__ == '__main__':
     print(f"-= {YELLOW}Running tests for {SHELL}{RESET} =-")
     unittest.main(testRunner = unittest.TextTestRunner(resultclass = PrettierTextTestResult))
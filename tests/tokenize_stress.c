@@ -0,0 +1,192 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// Stress test for the reentrant tokenizer: millions of generated lines are tokenized serially by the byte-by-byte scanner,
+// then again by several threads at once with the vectorized one, each with its own tokenizer_t (and a second one nested
+// within the first), and every result has to match the serial one.
+//
+// usage: ./tests/tokenize_stress [lines] [threads]
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+// ************** Including the necessary header file **************
+
+#include "../tokens.h"
+
+// ************** Define macros **************
+
+#define MAX_LINE 256 // longest generated line, including its \0
+
+// ************** Define global variables **************
+
+// lines full of delimiters, and lines with long words which span whole blocks of the vectorized scanner
+static const char dense_alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789-_./  \t\t\"\"()<>|&;\n";
+static const char sparse_alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_./ \"|";
+
+static size_t num_lines;     // how many lines are generated
+static int num_threads;      // how many threads tokenize them at once
+static uint64_t *expected;   // the hash of the serial result for each line
+static int failures;         // lines whose results didn't match (guarded by failures_lock)
+static pthread_mutex_t failures_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// ************** Defining the helpers **************
+
+// generating the line with the given index (the same index always gives the same line), returns its length
+
+static size_t make_line(size_t index, char *line)
+{
+  uint64_t state = index * 6364136223846793005ULL + 1442695040888963407ULL;
+  state ^= state >> 33;
+
+  size_t len = state % (MAX_LINE - 1);
+  const char *alphabet = (state & 0x100) ? dense_alphabet : sparse_alphabet;
+  size_t alphabet_size = (state & 0x100) ? sizeof(dense_alphabet) - 1 : sizeof(sparse_alphabet) - 1;
+
+  for (size_t i = 0; i < len; ++i)
+  {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    line[i] = alphabet[(state >> 33) % alphabet_size];
+  }
+  line[len] = '\0';
+  return len;
+}
+
+// hashing every token of a line along with the boundaries between them (FNV-1a)
+
+static uint64_t hash_tokens(char **tokens)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (; *tokens != NULL; ++tokens)
+  {
+    for (const char *c = *tokens; *c; ++c)
+    {
+      hash = (hash ^ (unsigned char)*c) * 1099511628211ULL;
+    }
+    hash = (hash ^ 0xff) * 1099511628211ULL; // the end of a token
+  }
+  return hash;
+}
+
+static void fail(size_t index, const char *what)
+{
+  pthread_mutex_lock(&failures_lock);
+  if (failures++ < 10)
+  {
+    char line[MAX_LINE];
+    make_line(index, line);
+    fprintf(stderr, "line %zu: %s: \"%s\"\n", index, what, line);
+  }
+  pthread_mutex_unlock(&failures_lock);
+}
+
+// tokenizing every num_threads-th line, starting at the thread's own index
+
+static void *worker(void *arg)
+{
+  size_t first = (size_t)arg;
+  tokenizer_t outer;
+  tokenizer_t inner;
+  char line[MAX_LINE];
+  char other[MAX_LINE];
+
+  tokenizer_init(&outer);
+  tokenizer_init(&inner);
+
+  // with AVX2 available, every other thread checks the SSE2 scanner instead
+  if (outer.scan_width == 32 && first % 2 == 1)
+  {
+    outer.scan_width = 16;
+    inner.scan_width = 16;
+  }
+
+  for (size_t index = first; index < num_lines; index += num_threads)
+  {
+    size_t len = make_line(index, line);
+    char **tokens = tokenize_into(&outer, line, len);
+
+    if (hash_tokens(tokens) != expected[index])
+    {
+      fail(index, "tokens differ from the serial tokenizer");
+    }
+
+    // tokenizing another line while the first one's tokens are still in use must not touch them
+    size_t other_index = (index * 7 + 3) % num_lines;
+    size_t other_len = make_line(other_index, other);
+    if (hash_tokens(tokenize_into(&inner, other, other_len)) != expected[other_index])
+    {
+      fail(other_index, "nested tokens differ from the serial tokenizer");
+    }
+    if (hash_tokens(tokens) != expected[index])
+    {
+      fail(index, "tokens changed by a nested tokenizer");
+    }
+  }
+
+  tokenizer_free(&outer);
+  tokenizer_free(&inner);
+  return NULL;
+}
+
+// ************** Defining the main function **************
+
+int main(int argc, char **argv)
+{
+  num_lines = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+  num_threads = (argc > 2) ? atoi(argv[2]) : 8;
+
+  expected = malloc(sizeof(uint64_t) * num_lines);
+  if (expected == NULL || num_threads < 1)
+  {
+    fprintf(stderr, "usage: %s [lines] [threads]\n", argv[0]);
+    return 1;
+  }
+
+  // the serial results, from the byte-by-byte scanner
+  tokenizer_t serial;
+  tokenizer_init(&serial);
+  unsigned char scan_width = serial.scan_width;
+  serial.scan_width = 0;
+
+  char line[MAX_LINE];
+  for (size_t index = 0; index < num_lines; ++index)
+  {
+    size_t len = make_line(index, line);
+    expected[index] = hash_tokens(tokenize_into(&serial, line, len));
+
+    // the compatibility wrappers have to give the same tokens as well
+    if (index % 16 == 0)
+    {
+      char **tokens = create_tokens(line);
+      if (hash_tokens(tokens) != expected[index])
+      {
+        fail(index, "create_tokens differs from the serial tokenizer");
+      }
+      free_tokens(tokens);
+    }
+  }
+  tokenizer_free(&serial);
+
+  pthread_t *threads = malloc(sizeof(pthread_t) * num_threads);
+  for (int t = 0; t < num_threads; ++t)
+  {
+    pthread_create(&threads[t], NULL, worker, (void *)(size_t)t);
+  }
+  for (int t = 0; t < num_threads; ++t)
+  {
+    pthread_join(threads[t], NULL);
+  }
+
+  printf("tokenized %zu lines on %d threads (scan width %d): %s (%d mismatches)\n",
+         num_lines, num_threads, scan_width, failures ? "FAIL" : "OK", failures);
+
+  free(threads);
+  free(expected);
+  return failures ? 1 : 0;
+}
@@ -5,6 +5,7 @@
 // ************** Including relevant libraries **************
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 
 // ************** Including the necessary header file **************
@@ -15,11 +16,16 @@
 
 // Demo for printing shell arguments parsed in tokens.c
 int main(int argc, char **argv) {
-  // initializing an array for holding the shell arguments as input
-  char input[256];
+  // the line of shell arguments as input, grown by getline as needed
+  char *input = NULL;
+  size_t capacity = 0;
 
   // getting input from the stdin stream and populating the input array with it
-  fgets(input, 256, stdin);
+  if (getline(&input, &capacity, stdin) == -1)
+  {
+    free(input);
+    return 0;
+  }
 
   // creating the tokens array (from tokens.c)
   char **tokens = create_tokens(input);
@@ -37,5 +43,6 @@ int main(int argc, char **argv) {
   }
 
   free_tokens(tokens); // freeing all memory held upon ending program
+  free(input);
   return 0;
 }
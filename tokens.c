@@ -4,184 +4,561 @@
 
 // ************** Including relevant libraries **************
 
+#define _GNU_SOURCE // for memmem
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <assert.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOKENS_X86 1 // whether the SSE2/AVX2 scanners can be built
+#endif
+
+// ************** Including the necessary header file **************
+
+#include "tokens.h"
+
 // ************** Define macros **************
 
-// for growing the size of the tokens array by 256 bytes every time we need to
+// for growing the size of the tokens array by 256 slots every time we need to
 #define GROW_SIZE 256
 
 // ************** Define global variables **************
 
-static int current_tokens_size; // current size for the tokens array (will be incremented as we add new tokens to it)
-static int max_tokens_capacity; // total capacity for tokens array
-static char **tokens = NULL;    // initial array for holding tokens
+// the type of the token made of each special character
+static const unsigned char operator_type[256] = {
+    ['('] = TOKEN_LPAREN, [')'] = TOKEN_RPAREN, ['>'] = TOKEN_REDIR_OUT, ['<'] = TOKEN_REDIR_IN,
+    ['|'] = TOKEN_PIPE, ['&'] = TOKEN_AMP, [';'] = TOKEN_SEMI};
+
+// the bytes which end the current token outside of a string: the special tokens, the separators, the quotation mark and \0
+static const unsigned char is_delimiter[256] = {
+    ['('] = 1, [')'] = 1, ['>'] = 1, ['<'] = 1, ['|'] = 1, ['&'] = 1, [';'] = 1,
+    [' '] = 1, ['\t'] = 1, ['\n'] = 1, ['"'] = 1, ['\0'] = 1};
+
+// the block of the input the scanner classified last, so that every delimiter in it can be found without looking at it again
+struct delimiter_cursor
+{
+  size_t base;   // where the block starts in the input (a multiple of the scan width)
+  uint32_t mask; // bit n is set when input[base + n] is a delimiter
+  int valid;     // whether a block has been classified yet
+};
 
 // ************** Declaring the necessary functions **************
 
-static void init_tokens();
-char **create_tokens(const char *input);
-static int get_string(const char *input, char *string);
-static void add_token(const char *token);
-void grow_tokens();
-void free_tokens(char **tokens);
+// there is no global state in here: everything a tokenizer needs lives in its context, so any number of them can be used at the
+// same time, on different threads or nested within each other
+
+static void arena_init(token_arena_t *arena);
+static void init_tokens(tokenizer_t *ctx, size_t len);
+static void append_char(tokenizer_t *ctx, char c);
+static void append_chars(tokenizer_t *ctx, const char *chars, size_t count);
+static unsigned char best_scan_width();
+static uint32_t classify_block(unsigned char width, const char *block);
+static size_t next_delimiter(const tokenizer_t *ctx, struct delimiter_cursor *cursor, const char *input, size_t from, size_t len);
+static size_t get_string(tokenizer_t *ctx, const char *input, size_t len);
+static size_t get_substitution(tokenizer_t *ctx, const char *input, size_t len);
+static size_t add_substitution(tokenizer_t *ctx, const char *input, size_t from, size_t len, token_type_t type);
+static void add_token(tokenizer_t *ctx, token_type_t type);
+static void grow_tokens(token_arena_t *arena);
 
 // ************** Defining the declared functions **************
 
-// initializing the tokens array
+// initializing an arena, which owns no memory until the first line is tokenized
 
-void init_tokens()
+static void arena_init(token_arena_t *arena)
 {
-  // since we are just initializing our tokens array here, we set the current size as 0
-  current_tokens_size = 0;
-  max_tokens_capacity = GROW_SIZE; // since we are initializing the tokens array, we give it the minimal size i.e GROW_SIZE
-  tokens = malloc(sizeof(char *) * max_tokens_capacity);
-  // making sure the tokens array is not empty after growing it (which was happening in some cases)
-  assert(tokens != NULL);
-  tokens[0] = NULL;
+  arena->chars = NULL;
+  arena->chars_used = 0;
+  arena->chars_capacity = 0;
+  arena->tokens = NULL;
+  arena->types = NULL;
+  arena->num_tokens = 0;
+  arena->tokens_capacity = 0;
 }
 
-// getting the tokens from the input string
+// initializing a tokenizer, which owns no memory until the first line is tokenized
 
-char **create_tokens(const char *input)
+void tokenizer_init(tokenizer_t *ctx)
+{
+  arena_init(&ctx->arena);
+  ctx->token_start = 0;
+  ctx->token_quoted = 0;
+  ctx->token_joined = 0;
+  ctx->scan_width = best_scan_width();
+}
+
+// releasing every token of the last line at once (the memory is kept for the next line)
+
+void tokenizer_reset(tokenizer_t *ctx)
+{
+  ctx->arena.chars_used = 0;
+  ctx->arena.num_tokens = 0;
+  if (ctx->arena.tokens != NULL)
+  {
+    ctx->arena.tokens[0] = NULL;
+  }
+  ctx->token_start = 0;
+  ctx->token_quoted = 0;
+  ctx->token_joined = 0;
+}
+
+// giving the memory held by a tokenizer back
+
+void tokenizer_free(tokenizer_t *ctx)
+{
+  free(ctx->arena.chars);
+  free(ctx->arena.tokens);
+  free(ctx->arena.types);
+  arena_init(&ctx->arena);
+  ctx->token_start = 0;
+  ctx->token_quoted = 0;
+  ctx->token_joined = 0;
+}
+
+// making sure the arena can hold every token of the input before we start writing to it
+
+static void init_tokens(tokenizer_t *ctx, size_t len)
+{
+  token_arena_t *arena = &ctx->arena;
+
+  // every byte of the input ends up as at most one character of a token, and every token takes at least one byte of input,
+  // so twice the length of the input (plus one) is always enough room for all the tokens and their terminating \0s.
+  // since the characters never move while we are writing them, the tokens can point straight into them.
+  size_t needed = 2 * len + 1;
+
+  tokenizer_reset(ctx);
+
+  if (arena->chars_capacity < needed)
+  {
+    free(arena->chars);
+    arena->chars = malloc(needed);
+    assert(arena->chars != NULL);
+    arena->chars_capacity = needed;
+  }
+
+  if (arena->tokens == NULL)
+  {
+    grow_tokens(arena);
+  }
+
+  arena->tokens[0] = NULL;
+}
+
+// getting the tokens from the first len bytes of the input (or up to its first \0), written into the tokenizer's arena
+
+char **tokenize_into(tokenizer_t *ctx, const char *input, size_t len)
 {
-  char string[256];             // our string of tokens
-  unsigned int args_iter = 0;   // for iterating over all of the shell arguments
-  unsigned int string_iter = 0; // for iterating over our string[] array of tokens
+  size_t args_iter = 0;                    // for iterating over all of the shell arguments
+  struct delimiter_cursor cursor = {0, 0, 0}; // no block of the input has been classified yet
 
   // initializing the tokens array before starting to populate it with the tokens
-  init_tokens();
+  init_tokens(ctx, len);
 
   // as long as there is some input coming from the shell
-  while (input[args_iter] != 0)
+  while (args_iter < len)
   {
+    // everything up to the next delimiter belongs to the current token, so it is found and copied over in one go
+    size_t next = next_delimiter(ctx, &cursor, input, args_iter, len);
+    append_chars(ctx, &input[args_iter], next - args_iter);
+    args_iter = next;
+
+    // the input ends at its first \0 (if there is one before len)
+    if (args_iter == len || input[args_iter] == 0)
+    {
+      break;
+    }
+
+    // $( starts a command substitution, whose whole command (up to the matching parenthesis) becomes a single token
+    // (a $ which was inside quotation marks is followed by the closing one, not by the parenthesis)
+    if (input[args_iter] == '(' && args_iter > 0 && input[args_iter - 1] == '$')
+    {
+      --ctx->arena.chars_used; // the $ isn't part of the word before it
+      args_iter = add_substitution(ctx, input, args_iter + 1, len, TOKEN_SUBST);
+      continue;
+    }
+
     switch (input[args_iter])
     {
     // for tokens
-    case '(':
-    case ')':
     case '>':
     case '<':
+      // a single digit right before a redirection (as in 2>) is the descriptor it is for, rather than an argument
+      if (ctx->arena.chars_used == ctx->token_start + 1 && !ctx->token_quoted &&
+          ctx->arena.chars[ctx->token_start] >= '0' && ctx->arena.chars[ctx->token_start] <= '9')
+      {
+        add_token(ctx, TOKEN_REDIR_FD);
+      }
+      // fall through
+    case '(':
+    case ')':
     case '|':
     case '&':
     case ';':
       // if we are already on a past token, we end it by \0 and prepare for taking the next argument
-      if (string_iter > 0)
-      {
-        string[string_iter] = '\0';
-        add_token(string);
-        string_iter = 0;
-      }
+      add_token(ctx, TOKEN_WORD);
       // getting the next token from shell as it is, and following it by a \0 to mark it as a string
-      string[0] = input[args_iter];
-      string[1] = '\0';
-      add_token(string);
+      append_char(ctx, input[args_iter]);
+      add_token(ctx, operator_type[(unsigned char)input[args_iter]]);
       break;
     // for special characters
     case ' ':
     case '\t':
     case '\n':
       // if we are already on a past token, we end it by \0 and prepare for taking the next argument
-      if (string_iter > 0)
-      {
-        string[string_iter] = '\0';
-        add_token(string);
-        string_iter = 0;
-      }
+      add_token(ctx, TOKEN_WORD);
       break;
     // for quotation mark (to be skipped)
     case '"':
+      ctx->token_quoted = 1;
       ++args_iter;
       // in case of a quotation, since we need to grab the entire proceeding string as it is, we do that
-      unsigned int bytes = get_string(&input[args_iter], &string[string_iter]);
-      // making our iterators skip over the following string sequence as we have a separate function for dealing with that string
-      args_iter += bytes;
-      string_iter += bytes;
+      // making our iterator skip over the following string sequence as we have a separate function for dealing with that string
+      args_iter += get_string(ctx, &input[args_iter], len - args_iter);
+      // a substitution inside the string is a token of its own, and the string goes on after it
+      while (args_iter + 1 < len && input[args_iter] == '$' && input[args_iter + 1] == '(')
+      {
+        args_iter = add_substitution(ctx, input, args_iter + 2, len, TOKEN_SUBST_QUOTED);
+        args_iter += get_string(ctx, &input[args_iter], len - args_iter);
+      }
+      // an unterminated string runs until the end of the input, and there is no closing quotation mark to skip
+      if (args_iter == len || input[args_iter] == 0)
+      {
+        continue;
+      }
       break;
-    default:
-      // in a neutral situation, we will just add a shell argument to our string of tokens and create room for the next shell argument
-      string[string_iter] = input[args_iter];
-      ++string_iter;
     }
     ++args_iter;
   }
 
-  // it is possible that we didn't place our last token in our string of tokens, so we will just grab that as well in such a case
-  if (string_iter > 0)
+  // it is possible that we didn't place our last token in the tokens array, so we will just grab that as well in such a case
+  add_token(ctx, TOKEN_WORD);
+
+  return ctx->arena.tokens;
+}
+
+// adding a single character to the token we are currently reading
+
+static void append_char(tokenizer_t *ctx, char c)
+{
+  ctx->arena.chars[ctx->arena.chars_used] = c;
+  ++ctx->arena.chars_used;
+}
+
+// adding a run of characters to the token we are currently reading
+
+static void append_chars(tokenizer_t *ctx, const char *chars, size_t count)
+{
+  memcpy(&ctx->arena.chars[ctx->arena.chars_used], chars, count);
+  ctx->arena.chars_used += count;
+}
+
+// reading a string argument from the shell as it is, up to its end or to the first substitution $( inside it
+
+static size_t get_string(tokenizer_t *ctx, const char *input, size_t len)
+{
+  // the string runs until the next quotation mark, or until the input ends (at len or at its first \0)
+  // all of these searches are vectorized by the C library
+  size_t limit = strnlen(input, len);
+  const char *quote = memchr(input, '"', limit);
+  size_t bytes = (quote != NULL) ? (size_t)(quote - input) : limit; // the space our token string will occupy
+  const char *subst = memmem(input, bytes, "$(", 2);
+  bytes = (subst != NULL) ? (size_t)(subst - input) : bytes;
+
+  // storing the whole string in the current token
+  append_chars(ctx, input, bytes);
+
+  return bytes;
+}
+
+// reading the command of a substitution as it is, up to the parenthesis matching the one before it (those inside strings, and
+// those of nested substitutions and groups, are skipped over)
+
+static size_t get_substitution(tokenizer_t *ctx, const char *input, size_t len)
+{
+  size_t bytes = 0; // the space our token string will occupy
+  int depth = 0;
+  int quoted = 0;
+
+  for (; bytes < len && input[bytes] != 0; ++bytes)
   {
-    string[string_iter] = 0;
-    add_token(string);
+    if (input[bytes] == '"')
+    {
+      quoted = !quoted;
+    }
+    else if (!quoted && input[bytes] == '(')
+    {
+      ++depth;
+    }
+    else if (!quoted && input[bytes] == ')' && depth-- == 0)
+    {
+      break;
+    }
   }
 
-  return tokens;
+  // storing the whole command in the current token
+  append_chars(ctx, input, bytes);
+
+  return bytes;
 }
 
-// reading a string argument from the shell as it is
+// ending the word read so far and adding the substitution whose command starts at input[from] (right after its $( ) as a token of
+// the given type; the substitution is joined to the word before it when there is one, and to whatever comes right after its )
+// returns where the input goes on, past the )
 
-int get_string(const char *input, char *string)
+static size_t add_substitution(tokenizer_t *ctx, const char *input, size_t from, size_t len, token_type_t type)
 {
-  unsigned int bytes = 0; // the space our token string will occupy
-  // as long as there is some valid input and not a quotation mark (as specified in instructions)
-  while (*input && *input != '"')
+  int joined = ctx->token_joined || ctx->arena.chars_used != ctx->token_start;
+  add_token(ctx, TOKEN_WORD);
+  ctx->token_joined = joined;
+
+  from += get_substitution(ctx, &input[from], len - from);
+  add_token(ctx, type);
+  ctx->token_joined = 1;
+
+  // an unterminated substitution runs until the end of the input, and there is no closing parenthesis to skip
+  return (from == len || input[from] == 0) ? from : from + 1;
+}
+
+// picking the widest scanner the CPU we are running on supports (0 for the byte-by-byte one)
+
+static unsigned char best_scan_width()
+{
+#ifdef TOKENS_X86
+  if (__builtin_cpu_supports("avx2"))
   {
-    *string = *input; // temporarily storing that string token
-    ++bytes;          // adding to the space occupied by the string
-    ++string;         // creating room for the next token
-    ++input;          // moving on to the next token
+    return 32;
   }
-  // since we are creating a string in C, we will end it by the \0 character
-  *string = '\0';
+  if (__builtin_cpu_supports("sse2"))
+  {
+    return 16;
+  }
+#endif
+  return 0;
+}
 
-  return bytes;
+#ifdef TOKENS_X86
+
+// comparing 16 bytes at once against every delimiter, giving one bit per byte
+
+__attribute__((target("sse2"))) static uint32_t classify_sse2(const char *block)
+{
+  __m128i bytes = _mm_loadu_si128((const __m128i *)block);
+  __m128i found = _mm_cmpeq_epi8(bytes, _mm_setzero_si128());
+
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('(')));
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(')')));
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('>')));
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('<')));
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('|')));
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('&')));
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(';')));
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')));
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')));
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+  found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')));
+
+  return (uint32_t)_mm_movemask_epi8(found);
+}
+
+// comparing 32 bytes at once against every delimiter, giving one bit per byte
+
+__attribute__((target("avx2"))) static uint32_t classify_avx2(const char *block)
+{
+  __m256i bytes = _mm256_loadu_si256((const __m256i *)block);
+  __m256i found = _mm256_cmpeq_epi8(bytes, _mm256_setzero_si256());
+
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('(')));
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(')')));
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('>')));
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('<')));
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('|')));
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('&')));
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(';')));
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')));
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t')));
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+  found = _mm256_or_si256(found, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')));
+
+  return (uint32_t)_mm256_movemask_epi8(found);
+}
+
+#endif
+
+// classifying a whole block of the input with the scanner of the given width
+
+static uint32_t classify_block(unsigned char width, const char *block)
+{
+#ifdef TOKENS_X86
+  if (width == 32)
+  {
+    return classify_avx2(block);
+  }
+  return classify_sse2(block);
+#else
+  (void)width;
+  (void)block;
+  return 0;
+#endif
+}
+
+// finding the first delimiter at or after from (or len if there is none)
+// the input is classified a whole block at a time, and the bits of the block are reused for every delimiter found in it,
+// so the scanner jumps straight from one token boundary to the next; only the last few bytes which don't fill a whole block
+// are looked at one by one
+
+static size_t next_delimiter(const tokenizer_t *ctx, struct delimiter_cursor *cursor, const char *input, size_t from, size_t len)
+{
+  size_t width = ctx->scan_width;
+
+  if (width != 0)
+  {
+    while (1)
+    {
+      size_t base = from & ~(width - 1); // the block holding from
+
+      // the block would run past the end of the input
+      if (base + width > len)
+      {
+        break;
+      }
+
+      if (!cursor->valid || cursor->base != base)
+      {
+        cursor->mask = classify_block(width, &input[base]);
+        cursor->base = base;
+        cursor->valid = 1;
+      }
+
+      uint32_t mask = cursor->mask >> (from - base); // only the delimiters at or after from
+      if (mask != 0)
+      {
+        return from + __builtin_ctz(mask);
+      }
+      from = base + width;
+    }
+  }
+
+  while (from < len && !is_delimiter[(unsigned char)input[from]])
+  {
+    ++from;
+  }
+  return from;
 }
 
-// adding a token from the string to the array in our program
+// ending the token we are currently reading (if any) and adding it to the tokens array, as a token of the given type
 
-void add_token(const char *token)
+static void add_token(tokenizer_t *ctx, token_type_t type)
 {
-  assert(token != NULL); // making sure the token isn't invalid (empty)
+  token_arena_t *arena = &ctx->arena;
+
+  // nothing has been read since the last token ended
+  if (arena->chars_used == ctx->token_start)
+  {
+    ctx->token_quoted = 0;
+    ctx->token_joined = 0;
+    return;
+  }
+
+  // since we are creating a string in C, we will end it by the \0 character
+  append_char(ctx, '\0');
 
   // if the capacity for the tokens array has been reached, growing that array to fit in the new tokens
-  if ((current_tokens_size + 1) == max_tokens_capacity)
+  if ((arena->num_tokens + 1) == arena->tokens_capacity)
   {
-    grow_tokens();
+    grow_tokens(arena);
   }
 
-  // throwing the new token into our (possibly expanded) tokens array
-  char *new_token = strdup(token);
   // since this is the latest token we have added to our tokens array so far, it should be the last one in there
-  tokens[current_tokens_size] = new_token;
+  arena->tokens[arena->num_tokens] = &arena->chars[ctx->token_start];
+  arena->types[arena->num_tokens] = type | (ctx->token_joined ? TOKEN_JOINED : 0);
   // now that we added a new token, we increment the size of our tokens array by 1
-  ++current_tokens_size;
+  ++arena->num_tokens;
   // since we are one step ahead in our tokens array, we temporarily keep that last element as NULL and populate it later
-  tokens[current_tokens_size] = NULL;
+  arena->tokens[arena->num_tokens] = NULL;
+
+  ctx->token_start = arena->chars_used;
+  ctx->token_quoted = 0;
+  ctx->token_joined = 0;
 }
 
 // in case more tokens are there than initialized, using dynamic memory allocation to add to the initial array
 
-void grow_tokens()
+static void grow_tokens(token_arena_t *arena)
 {
-  max_tokens_capacity += GROW_SIZE; // GROW_SIZE is our macro which
-  tokens = realloc(tokens, sizeof(char *) * max_tokens_capacity);
+  arena->tokens_capacity += GROW_SIZE; // GROW_SIZE is our macro which
+  arena->tokens = realloc(arena->tokens, sizeof(char *) * arena->tokens_capacity);
+  arena->types = realloc(arena->types, arena->tokens_capacity);
   // making sure the tokens array is not empty after growing it (which was happening in some cases, somehow)
+  assert(arena->tokens != NULL && arena->types != NULL);
+}
+
+// getting the tokens from the input string, as a single block of memory owned by the caller
+
+char **create_tokens(const char *input)
+{
+  tokenizer_t ctx;
+  tokenizer_init(&ctx);
+  tokenize_into(&ctx, input, strlen(input));
+
+  token_arena_t line = ctx.arena;
+
+  // the pointers and the characters they point to are copied into one allocation, which free_tokens gives back in one go
+  size_t pointers_size = sizeof(char *) * (line.num_tokens + 1);
+  char **tokens = malloc(pointers_size + line.chars_used);
   assert(tokens != NULL);
+
+  char *chars = (char *)tokens + pointers_size;
+  memcpy(chars, line.chars, line.chars_used);
+
+  for (size_t index = 0; index < line.num_tokens; ++index)
+  {
+    tokens[index] = chars + (line.tokens[index] - line.chars);
+  }
+  tokens[line.num_tokens] = NULL;
+
+  tokenizer_free(&ctx);
+  return tokens;
 }
 
 // freeing the memory held by the tokens array
 
 void free_tokens(char **tokens)
 {
-  char **tokens_copy = tokens; // a copy of the tokens array to free everything inside it sequentially
+  // the tokens live in the same block as the array itself (see create_tokens)
+  free(tokens);
+}
+
+// getting the length of the command starting at cmd: up to the first ; which isn't part of a string, or the end of the input
 
-  // since our tokens are strings and strings are arrays of chars, we have to free them first
-  while (*tokens_copy != NULL)
+size_t command_length(const char *cmd, size_t len)
+{
+  int in_string = 0; // whether we are between two quotation marks
+  int depth = 0;     // how many parentheses are open (the commands of a group all belong to the command it is part of)
+
+  for (size_t index = 0; index < len; ++index)
   {
-    free(*tokens_copy);
-    ++tokens_copy;
+    if (cmd[index] == '"')
+    {
+      in_string = !in_string;
+    }
+    else if (in_string)
+    {
+      continue;
+    }
+    else if (cmd[index] == '(')
+    {
+      ++depth;
+    }
+    else if (cmd[index] == ')' && depth > 0)
+    {
+      --depth;
+    }
+    else if (cmd[index] == ';' && depth == 0)
+    {
+      return index;
+    }
   }
-
-  free(tokens); // finally freeing the tokens array itself
+  return len;
 }
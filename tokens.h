@@ -5,20 +5,81 @@
 #ifndef _TOKENS_H
 #define _TOKENS_H
 
-// initializing the tokens array
-void init_tokens();
+#include <stddef.h>
 
-// getting the tokens from the input string
-char **create_tokens(const char *input);
+// what a token stands for: one of the operators, or a word (anything inside quotation marks is always a word, so "|" is just
+// the character |)
+typedef enum token_type
+{
+  TOKEN_WORD,
+  TOKEN_PIPE,      // |
+  TOKEN_REDIR_IN,  // <
+  TOKEN_REDIR_OUT, // >
+  TOKEN_SEMI,      // ;
+  TOKEN_AMP,       // &
+  TOKEN_LPAREN,    // (
+  TOKEN_RPAREN,    // )
+  TOKEN_REDIR_FD,  // the descriptor a redirection is for: a single digit right before a < or > (the 2 of 2>), outside of quotes
+  TOKEN_SUBST,     // a command substitution $( ... ) outside of quotes: the token holds the command inside the parentheses
+  TOKEN_SUBST_QUOTED, // a command substitution inside quotes ("$( ... )"), whose whole output is a single word
+} token_type_t;
+
+// set on the type of a word or substitution which directly follows another one of them, with nothing in between (the $(b) and the
+// c of a$(b)c): once the substitutions have been expanded, it is glued onto the word before it
+#define TOKEN_JOINED 0x80
+
+// the type of a token without its TOKEN_JOINED flag
+#define TOKEN_TYPE(type) ((token_type_t)((type) & ~TOKEN_JOINED))
+
+// the memory the tokens of a line are written to
+// every token of a line lives in a single buffer of characters, so the whole line is released with a single reset,
+// and the memory is kept around for the next line instead of being allocated again
+typedef struct token_arena
+{
+  char *chars;            // the characters of every token, each followed by a \0
+  size_t chars_used;      // how many characters have been written so far
+  size_t chars_capacity;  // total capacity of chars
+  char **tokens;          // the tokens, pointing into chars, terminated by NULL
+  unsigned char *types;   // the type of each token (a token_type_t), in step with tokens
+  size_t num_tokens;      // how many tokens there are
+  size_t tokens_capacity; // total capacity for tokens
+} token_arena_t;
+
+// everything needed to tokenize lines: the arena the tokens are written to, and where the tokenizer is within the current line
+// a tokenizer keeps no state outside of this, so every thread (or every nested use) can have its own
+typedef struct tokenizer
+{
+  token_arena_t arena; // the tokens of the last line
+  size_t token_start;  // where the token currently being read starts in the arena's characters
+  int token_quoted;    // whether some of the token currently being read was inside quotation marks
+  int token_joined;    // whether the token currently being read is joined to the one before it (see TOKEN_JOINED)
 
-// adding a token from the string to the array in our program
-void add_token(const char* token);
+  // how many bytes of the input are classified at once when looking for the end of a token: 32 (AVX2), 16 (SSE2),
+  // or 0 to look at them one by one. tokenizer_init picks the widest one the CPU supports; every width gives the same tokens.
+  unsigned char scan_width;
+} tokenizer_t;
 
-// reading a string  argument from the shell as it is
-int get_string(const char *input, char *string);
+// initializing a tokenizer, which owns no memory until the first line is tokenized
+void tokenizer_init(tokenizer_t *ctx);
 
-// in case more tokens are there than initialized, using dynamic memory allocation to add to the initial array
-void grow_tokens();
+// getting the tokens from the first len bytes of the input (or up to its first \0), written into the tokenizer's arena
+// (replacing the previous line's tokens); the tokens stay valid until the tokenizer is reset, used for another line or freed
+// the type of each token is found in the arena's types, so nothing has to look at the characters of a token to tell an operator
+// from a word
+char **tokenize_into(tokenizer_t *ctx, const char *input, size_t len);
+
+// releasing every token of the last line at once (the memory is kept for the next line)
+void tokenizer_reset(tokenizer_t *ctx);
+
+// giving the memory held by a tokenizer back
+void tokenizer_free(tokenizer_t *ctx);
+
+// getting the length of the command starting at cmd (of at most len bytes): up to the first ; which isn't part of a string or
+// inside parentheses (of a group or a substitution)
+size_t command_length(const char *cmd, size_t len);
+
+// getting the tokens from the input string, as a single block of memory which has to be given to free_tokens
+char **create_tokens(const char *input);
 
 // freeing the memory held by the tokens array
 void free_tokens(char **tokens);
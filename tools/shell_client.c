@@ -0,0 +1,150 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// Runs commands on a shell server (./shell --server SOCKET) instead of launching a shell for them: the commands are sent over the
+// socket along with this process's stdin, stdout and stderr, which they use directly, and the client exits with their status.
+//
+// usage: tools/shell_client SOCKET -c 'commands'
+//        tools/shell_client SOCKET script
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// ************** Including the necessary header file **************
+
+#include "../server.h"
+
+// ************** Defining the functions **************
+
+// writing the whole buffer, however many write calls it takes
+// returns 0, or -1 if writing failed
+static int write_all(int fd, const char *buffer, size_t size)
+{
+  while (size > 0)
+  {
+    ssize_t written = write(fd, buffer, size);
+    if (written == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (written == -1)
+    {
+      return -1;
+    }
+    buffer += written;
+    size -= written;
+  }
+  return 0;
+}
+
+// reading a whole script into memory
+// returns its contents (with its length in len), or NULL if it couldn't be read
+static char *read_script(const char *path, size_t *len)
+{
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  struct stat info;
+  if (fd == -1 || fstat(fd, &info) == -1)
+  {
+    return NULL;
+  }
+
+  char *script = malloc(info.st_size + 1);
+  size_t used = 0;
+  while (script != NULL && used < (size_t)info.st_size)
+  {
+    ssize_t got = read(fd, &script[used], info.st_size - used);
+    if (got == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (got <= 0)
+    {
+      break;
+    }
+    used += got;
+  }
+  *len = used;
+  close(fd);
+  return script;
+}
+
+int main(int argc, char **argv)
+{
+  int inline_commands = (argc == 4 && strcmp(argv[2], "-c") == 0);
+  if (argc != 3 && !inline_commands)
+  {
+    fprintf(stderr, "usage: %s SOCKET -c 'commands' | %s SOCKET script\n", argv[0], argv[0]);
+    return 2;
+  }
+
+  size_t len;
+  char *commands = inline_commands ? argv[3] : read_script(argv[2], &len);
+  if (commands == NULL)
+  {
+    perror(argv[2]);
+    return 127;
+  }
+  if (inline_commands)
+  {
+    len = strlen(commands);
+  }
+
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+  int conn = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (conn == -1 || connect(conn, (struct sockaddr *)&address, sizeof(address)) == -1)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  // the header goes along with our stdin, stdout and stderr
+  server_request_t header = {SERVER_MAGIC, (uint32_t)len};
+  int fds[3] = {0, 1, 2};
+  char control[CMSG_SPACE(sizeof(fds))];
+  memset(control, 0, sizeof(control));
+  struct iovec part = {&header, sizeof(header)};
+  struct msghdr message = {.msg_iov = &part, .msg_iovlen = 1, .msg_control = control, .msg_controllen = sizeof(control)};
+  struct cmsghdr *rights = CMSG_FIRSTHDR(&message);
+  rights->cmsg_level = SOL_SOCKET;
+  rights->cmsg_type = SCM_RIGHTS;
+  rights->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(rights), fds, sizeof(fds));
+
+  if (sendmsg(conn, &message, 0) != sizeof(header) || write_all(conn, commands, len) == -1)
+  {
+    perror("Error sending the commands");
+    return 1;
+  }
+
+  // the status comes once the commands are done (and everything they wrote has been written)
+  int32_t status;
+  char *cursor = (char *)&status;
+  size_t left = sizeof(status);
+  while (left > 0)
+  {
+    ssize_t got = read(conn, cursor, left);
+    if (got == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (got <= 0)
+    {
+      fprintf(stderr, "%s: the server went away before the commands were done\n", argv[0]);
+      return 1;
+    }
+    cursor += got;
+    left -= got;
+  }
+  return status;
+}
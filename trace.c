@@ -0,0 +1,248 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+// ************** Including relevant libraries **************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+// ************** Including the necessary header file **************
+
+#include "trace.h"
+#include "stats.h" // for the monotonic clock
+
+// ************** Define macros **************
+
+#define TRACE_CAPACITY 4096 // how many events the ring buffer holds (a power of two)
+#define TRACE_BATCH 512     // how many events are written out at once, unless the shell is about to wait for input
+#define TRACE_NAME_SIZE 24  // how much of the first word of argv is kept (along with its \0)
+#define TRACE_LINE_SIZE 256 // the most a single event can take once written out
+
+// ************** Define global variables **************
+
+// a single event waiting to be written out
+struct trace_record
+{
+  // the position of the record in the ring (plus one) once it has been written, so that the writer can tell a record which is
+  // complete from one which is still being filled in
+  _Atomic uint64_t sequence;
+  uint64_t time;
+  uint64_t hash; // of the whole of argv
+  long value;
+  int child;
+  unsigned char type;
+  char name[TRACE_NAME_SIZE];
+};
+
+// the ring buffer: positions are claimed at head (by the shell, or by its SIGCHLD handler in the middle of it) and written out
+// from tail, so an event never waits on a lock, and nothing is ever allocated for it
+static struct trace_record ring[TRACE_CAPACITY];
+static _Atomic uint64_t head;
+static _Atomic uint64_t tail;
+static _Atomic uint64_t dropped; // the events which didn't fit in the ring
+
+static int trace_fd = -1; // the trace file (-1 when nothing is traced)
+static pid_t shell_pid;
+
+static const char *const trace_names[NUM_TRACE_TYPES] = {
+    "line_read", "line_begin", "line_end", "tokenize_begin", "tokenize_end", "command_begin", "command_end",
+    "run_begin", "run_end", "fork", "exec", "child_exit", "redirect_open", "pipe_create"};
+
+// ************** Declaring helper functions **************
+
+static void write_all(const char *buffer, size_t size);
+static size_t format_record(char *buffer, const struct trace_record *record);
+
+// ************** Defining the functions **************
+
+// starting to trace into the file at path
+
+int trace_open(const char *path)
+{
+  trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+  if (trace_fd == -1)
+  {
+    perror(path);
+    return -1;
+  }
+  shell_pid = getpid();
+  return 0;
+}
+
+// whether events are being traced at all
+
+int trace_enabled()
+{
+  return trace_fd != -1;
+}
+
+// recording an event into the ring buffer
+
+void trace_event(trace_type_t type, char *const *argv, pid_t child, long value)
+{
+  if (trace_fd == -1)
+  {
+    return;
+  }
+
+  int saved_errno = errno;
+
+  // claiming the next position, unless the ring is full (in which case the event is only counted)
+  uint64_t position = atomic_load(&head);
+  do
+  {
+    if (position - atomic_load(&tail) >= TRACE_CAPACITY)
+    {
+      atomic_fetch_add(&dropped, 1);
+      return;
+    }
+  } while (!atomic_compare_exchange_weak(&head, &position, position + 1));
+
+  struct trace_record *record = &ring[position & (TRACE_CAPACITY - 1)];
+  record->time = stats_now();
+  record->type = type;
+  record->child = child;
+  record->value = value;
+  record->hash = 0;
+  record->name[0] = '\0';
+
+  if (argv != NULL)
+  {
+    // FNV-1a over every word (each followed by its \0), so that the same command always gets the same hash
+    uint64_t hash = 14695981039346656037ull;
+    for (int word = 0; argv[word] != NULL; ++word)
+    {
+      const unsigned char *cursor = (const unsigned char *)argv[word];
+      do
+      {
+        hash = (hash ^ *cursor) * 1099511628211ull;
+      } while (*cursor++ != '\0');
+    }
+    record->hash = hash;
+
+    // keeping just the characters which never need escaping in JSON
+    size_t length = 0;
+    if (argv[0] != NULL)
+    {
+      for (; argv[0][length] != '\0' && length < TRACE_NAME_SIZE - 1; ++length)
+      {
+        char c = argv[0][length];
+        record->name[length] = (c > ' ' && c < 127 && c != '"' && c != '\\') ? c : '?';
+      }
+    }
+    record->name[length] = '\0';
+  }
+
+  atomic_store_explicit(&record->sequence, position + 1, memory_order_release);
+  errno = saved_errno;
+}
+
+// writing the whole buffer, however many write calls it takes
+
+static void write_all(const char *buffer, size_t size)
+{
+  while (size > 0)
+  {
+    ssize_t written = write(trace_fd, buffer, size);
+    if (written == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (written <= 0)
+    {
+      return; // nothing more can be done about it
+    }
+    buffer += written;
+    size -= written;
+  }
+}
+
+// writing a single event as a line of JSON
+
+static size_t format_record(char *buffer, const struct trace_record *record)
+{
+  int length = snprintf(buffer, TRACE_LINE_SIZE,
+                        "{\"ts\":%llu,\"event\":\"%s\",\"pid\":%d,\"child\":%d,\"argv\":\"%016llx\",\"name\":\"%s\",\"value\":%ld}\n",
+                        (unsigned long long)record->time, trace_names[record->type], (int)shell_pid, record->child,
+                        (unsigned long long)record->hash, record->name, record->value);
+  return (length < TRACE_LINE_SIZE) ? (size_t)length : TRACE_LINE_SIZE - 1;
+}
+
+// writing the recorded events out, a whole batch of them with a single write
+
+void trace_flush(int force)
+{
+  if (trace_fd == -1)
+  {
+    return;
+  }
+
+  uint64_t position = atomic_load(&tail);
+  uint64_t end = atomic_load(&head);
+  if (!force && end - position < TRACE_BATCH)
+  {
+    return;
+  }
+
+  char buffer[TRACE_BATCH * 128];
+  size_t used = 0;
+
+  for (; position < end; ++position)
+  {
+    const struct trace_record *record = &ring[position & (TRACE_CAPACITY - 1)];
+
+    // a record which is still being filled in is left for the next time
+    if (atomic_load_explicit(&record->sequence, memory_order_acquire) != position + 1)
+    {
+      break;
+    }
+    if (used + TRACE_LINE_SIZE > sizeof(buffer))
+    {
+      write_all(buffer, used);
+      used = 0;
+    }
+    used += format_record(&buffer[used], record);
+
+    // the record has been copied out, so its slot can be claimed again
+    atomic_store(&tail, position + 1);
+  }
+
+  uint64_t lost = atomic_exchange(&dropped, 0);
+  if (lost > 0)
+  {
+    if (used + TRACE_LINE_SIZE > sizeof(buffer))
+    {
+      write_all(buffer, used);
+      used = 0;
+    }
+    used += snprintf(&buffer[used], TRACE_LINE_SIZE, "{\"ts\":%llu,\"event\":\"dropped\",\"pid\":%d,\"value\":%llu}\n",
+                     (unsigned long long)stats_now(), (int)shell_pid, (unsigned long long)lost);
+  }
+  write_all(buffer, used);
+}
+
+// writing out every recorded event and closing the trace file
+
+void trace_close()
+{
+  if (trace_fd == -1)
+  {
+    return;
+  }
+  trace_flush(1);
+  close(trace_fd);
+  trace_fd = -1;
+}
+
+// stopping tracing in a forked child, leaving the trace file to the shell
+
+void trace_detach()
+{
+  trace_fd = -1;
+}
@@ -0,0 +1,54 @@
+// Authors: Abdulwadood Ashraf Faazli, Muhammad Mubeen
+// NUID: 002601201, 002604679
+// Project 1 - Shell - CS3650
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+// the events the shell can trace
+// the ones ending with _BEGIN and _END come in pairs, with the others in between them belonging to them
+typedef enum trace_type
+{
+  TRACE_LINE_READ,       // a line was read at the prompt (value: its length)
+  TRACE_LINE_BEGIN,      // sepCommmand starts on a line (value: its length)
+  TRACE_LINE_END,
+  TRACE_TOKENIZE_BEGIN,  // a command is being tokenized (value: its length)
+  TRACE_TOKENIZE_END,    // (value: the number of tokens)
+  TRACE_COMMAND_BEGIN,   // manageShell starts on a command (argv: its tokens)
+  TRACE_COMMAND_END,
+  TRACE_RUN_BEGIN,       // a pipeline (or a single program) is run in the foreground (argv: its first stage)
+  TRACE_RUN_END,
+  TRACE_FORK,            // a program is being launched (argv: the program and its arguments)
+  TRACE_EXEC,            // it has been launched (child: its pid, or -1 if it couldn't be, with errno in value)
+  TRACE_CHILD_EXIT,      // a child has been reaped (child: its pid, value: its wait status)
+  TRACE_REDIRECT_OPEN,   // a file has been opened for a redirection (argv: the file, value: the descriptor, or -1)
+  TRACE_PIPE_CREATE,     // a pipe has been created (value: its read end, child: its write end)
+  NUM_TRACE_TYPES
+} trace_type_t;
+
+// starting to trace into the file at path (truncating it), one JSON object per line and per event
+// returns -1 if it couldn't be opened, in which case nothing is traced
+int trace_open(const char *path);
+
+// whether events are being traced at all
+int trace_enabled();
+
+// recording an event (with argv, terminated by NULL, hashed and its first word kept as the name of the event; argv can be NULL)
+// this only ever writes into a ring buffer (it is safe to call from a signal handler) and does nothing unless tracing is enabled
+void trace_event(trace_type_t type, char *const *argv, pid_t child, long value);
+
+// writing the recorded events to the trace file once a whole batch of them is waiting (or all of them, with force)
+// must not be called from a signal handler
+void trace_flush(int force);
+
+// writing out every recorded event and closing the trace file
+void trace_close();
+
+// stopping tracing in a child forked from the shell, without writing out anything (what is in its copy of the ring buffer was
+// recorded by the shell, which writes it out itself)
+void trace_detach();
+
+#endif /* _TRACE_H */